@@ -5,6 +5,7 @@
 #include <atomic>
 #include <cstdint>
 #include <functional>
+#include <span>
 #include <thread>
 #include <vector>
 
@@ -13,13 +14,16 @@ struct ALCcontext;
 
 class AudioMaker {
 public:
-    using GetData = std::function<std::vector<std::int16_t>()>;
+    // Fills the buffer with samples and returns how many, it may block until they are there.
+    using GetData = std::function<std::size_t(std::span<std::int16_t>)>;
 
     explicit AudioMaker(int sampleRate = 44100, int channelCount = 1);
     ~AudioMaker();
 
     void setCallback(GetData f);
     void setProcessingInterval(int ms);
+    // The number of samples queued to OpenAL at a time, for all channels.
+    void setBufferSize(std::size_t sampleCount);
 
     void run();
     void stop();
@@ -46,6 +50,8 @@ private:
     int processingInterval;
 
     GetData getData;
+    // Allocated once, and refilled for each buffer.
+    std::vector<std::int16_t> data;
 };
 
 #endif // OCFBNJ_AUDIO_MAKER_H
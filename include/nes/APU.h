@@ -1,50 +1,93 @@
 #ifndef OCFBNJ_NES_APU_H
 #define OCFBNJ_NES_APU_H
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <istream>
 #include <ostream>
+#include <span>
 
+#include <nes/APU/BlipBuffer.h>
 #include <nes/APU/DMC.h>
 #include <nes/APU/Noise.h>
 #include <nes/APU/Pulse.h>
 #include <nes/APU/StatusRegister.h>
 #include <nes/APU/Triangle.h>
+#include <nes/literals.h>
 
 class Bus;
 
 class APU {
 public:
-    using SampleCallback = std::function<void(double sample)>;
+    // Samples are buffered as they are produced, several frames' worth at most.
+    // Once the buffer is full, the oldest samples are dropped until it is read.
+    static constexpr std::size_t SampleBufferSize = 4096;
 
     void connect(Bus* bus);
 
     void clock();
+    // Clocks `cycles` APU cycles at once, which must not go past the next event.
+    void run(std::uint64_t cycles);
+    // APU cycles until the next one that changes anything: a frame counter step (and maybe its IRQ),
+    // a DMC sample fetch, or a change of a channel output. Clocking up to there can be skipped until then.
+    std::uint64_t cyclesUntilEvent() const;
     void reset();
 
     std::uint8_t apuRead(std::uint16_t addr);
     void apuWrite(std::uint16_t addr, std::uint8_t data);
 
     void setSampleRate(int rate);
-    void setSampleCallback(SampleCallback callback);
+
+    // Move the buffered samples, oldest first, into `samples` and return how many there were room for.
+    // Called once per frame, they hand back that frame's worth of samples.
+    // The int16 samples are scaled for playback, the float ones are the mixer output (0.0 to 1.0).
+    std::size_t readSamples(std::span<std::int16_t> samples);
+    std::size_t readSamples(std::span<float> samples);
+    std::size_t bufferedSamples() const;
 
     void serialize(std::ostream& os) const;
     void deserialize(std::istream& is);
 
 private:
+    // EventClock fires `rate` times every ApuFrequency cycles, on the cycles ceil(k * ApuFrequency / rate).
+    // The fraction of a cycle left over by each period is carried to the next one, so it never drifts.
+    struct EventClock {
+        // Schedules the first event after `cycle`.
+        EventClock(std::uint32_t rate, std::uint64_t cycle);
+
+        void advance();
+
+        std::uint64_t next;    // cycle of the next event
+        std::uint32_t rate;    // events per ApuFrequency cycles
+        std::uint32_t carried; // (k * ApuFrequency + rate - 1) % rate, for the next event k
+    };
+
     std::uint8_t readStatus() const;
 
     void writeStatus(std::uint8_t data);
     void writeFrameCounter(std::uint8_t data);
 
-    void stepTimer();
+    // The channels only do something observable when a timer reloads, or when a register or the frame counter
+    // changes them. Between two such events, they are run all at once.
+    void runChannels(std::uint32_t cycles);
+    // Runs the channels up to `cycle`, which must not be past eventCycle.
+    void sync();
+    // Handles eventCycle, once the cycle is there.
+    void update();
+    void scheduleEvent();
+
     void stepLengthCounter();
     void stepEnvelopeAndLinearCounter();
     void stepSweep();
     void stepFrameCounter();
 
-    void sendSample();
+    // Adds the change of the mixer output, if any, to the blip buffer.
+    void updateOutput();
+    // Starts the blip buffer over from the current mixer output.
+    void restartOutput();
+    template <typename Sample, typename Convert>
+    std::size_t readSamples(std::span<Sample> samples, Convert convert);
 
     double getOutputSample() const;
 
@@ -61,14 +104,18 @@ private:
 
     StatusRegister status;
 
-    // With 64-bit integer and 44'100 sample rate, it can be stable for about 27 hours.
-    std::uint64_t i = 0;
+    std::uint64_t cycle = 0;
+    std::uint64_t channelCycle = 0; // the cycle the channels are at
+    std::uint64_t eventCycle = 1;   // the next cycle something happens at
+    EventClock frameCounterClock{FrameCounterFrequency, 0};
     // APU Components End
 
     Bus* bus = nullptr;
 
+    // Not saved, they follow the sample rate of the frontend.
     int sampleRate = 44100;
-    SampleCallback sampleCallback;
+    std::int32_t outputAmplitude = 0;
+    BlipBuffer blip;
 };
 
 #endif
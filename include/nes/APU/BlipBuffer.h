@@ -0,0 +1,49 @@
+#ifndef OCFBNJ_NES_BLIP_BUFFER_H
+#define OCFBNJ_NES_BLIP_BUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// BlipBuffer turns the changes of a signal clocked at `clockRate` into samples at `sampleRate`.
+// Each change is added as a band-limited step, so the samples have no aliasing,
+// and nothing is done for the clock cycles where the signal stays the same.
+// See http://www.slack.net/~ant/bl-synth/
+class BlipBuffer {
+public:
+    static constexpr int Phases = 32;    // positions of a step between two samples
+    static constexpr int Taps = 16;      // samples a step is spread over
+    static constexpr int KernelBits = 13; // the taps of a step add up to 1 << KernelBits
+
+    // Samples not read yet are kept up to about this many.
+    static constexpr std::size_t Capacity = 8192;
+
+    // Drops every sample, the signal is at `amplitude` from the clock cycle `time` on.
+    void reset(std::uint32_t clockRate, std::uint32_t sampleRate, std::uint64_t time, std::int32_t amplitude);
+
+    // The signal changes by `delta` at the clock cycle `time`, which must not go backward.
+    void addDelta(std::uint64_t time, std::int32_t delta);
+
+    // Samples that no change at the clock cycle `time` or later can alter any more.
+    std::size_t samplesAvailable(std::uint64_t time) const;
+    // Moves up to amplitudes.size() of the samples available at `time` into `amplitudes`, oldest first.
+    std::size_t read(std::uint64_t time, std::span<std::int32_t> amplitudes);
+    // Drops the oldest `count` samples.
+    void discard(std::size_t count);
+
+private:
+    // the sample at the clock cycle `time`, and how far into it in 1 / clockRate
+    std::uint64_t position(std::uint64_t time) const;
+
+    std::uint32_t clockRate = 1;
+    std::uint32_t sampleRate = 1;
+
+    // The deltas of the samples from `readIndex` on, in a ring.
+    std::array<std::int32_t, Capacity> deltas{};
+    std::uint64_t readIndex = 0;
+    // the sum of the deltas read so far, in 1 / (1 << KernelBits)
+    std::int32_t sum = 0;
+};
+
+#endif // OCFBNJ_NES_BLIP_BUFFER_H
@@ -11,12 +11,14 @@ class DMC {
 public:
     std::uint16_t getCurrentLength() const;
     std::uint8_t output() const;
+    // APU cycles until the next sample byte read or output change, or Timer::Never when there is none.
+    std::uint32_t cyclesUntilChange() const;
 
     void connect(Bus* bus);
 
     void resetCurrentLength();
 
-    void stepTimer();
+    void run(std::uint32_t cycles);
     void stepReader();
     void stepShifter();
 
@@ -11,10 +11,12 @@ class Noise {
 public:
     bool lengthGreaterThanZero() const;
     std::uint8_t output() const;
+    // APU cycles until the output may change, or Timer::Never while the channel is silent.
+    std::uint32_t cyclesUntilChange() const;
 
     void resetLengthCounter();
 
-    void stepTimer();
+    void run(std::uint32_t cycles);
     void stepLengthCounter();
     void stepEnvelope();
 
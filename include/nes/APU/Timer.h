@@ -2,12 +2,19 @@
 #define OCFBNJ_NES_TIMER_H
 
 #include <cstdint>
+#include <limits>
 
 struct Timer {
-    bool step();
+    // Returned by the channels when no timer step can change their output.
+    static constexpr std::uint32_t Never = std::numeric_limits<std::uint32_t>::max();
+
+    // Runs `steps` steps at once and returns how many times the counter reached 0 and was reloaded.
+    std::uint32_t run(std::uint32_t steps);
+    // Steps until the counter is reloaded next.
+    std::uint32_t stepsUntilReload() const;
 
     std::uint16_t counter = 0;
     std::uint16_t period = 0;
 };
 
-#endif // OCFBNJ_NES_TIMER_H
\ No newline at end of file
+#endif // OCFBNJ_NES_TIMER_H
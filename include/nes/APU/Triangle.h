@@ -10,10 +10,12 @@ class Triangle {
 public:
     bool lengthGreaterThanZero() const;
     std::uint8_t output() const;
+    // APU cycles until the output may change, or Timer::Never while the sequencer is halted.
+    std::uint32_t cyclesUntilChange() const;
 
     void resetLengthCounter();
 
-    void stepTimer();
+    void run(std::uint32_t cycles);
     void stepLengthCounter();
     void stepLinearCounter();
 
@@ -22,6 +24,8 @@ public:
     void writeTimerHi(std::uint8_t data);
 
 private:
+    bool halted() const;
+
     std::uint8_t linearCounterPeriod = 0;
     std::uint8_t linearCounterValue = 0;
     std::uint8_t dutyValue = 0;
@@ -0,0 +1,40 @@
+#ifndef OCFBNJ_NES_BACKGROUND_CANVAS_H
+#define OCFBNJ_NES_BACKGROUND_CANVAS_H
+
+#include <array>
+#include <cstdint>
+
+class Bus;
+
+// BackgroundCanvas holds the four name tables drawn as background pixels (palette << 2 | pixel),
+// laid out like the name tables: $2000 top left, $2400 top right, $2800 bottom left and $2C00 bottom right.
+// The background of a scanline is then read from the canvas at the scroll position instead of being fetched.
+// Tiles are drawn again on first use after their name table or attribute byte, the pattern tables,
+// or the banks and mirroring change. Colors are resolved later, so palette writes leave the canvas as is.
+// See https://www.nesdev.org/wiki/PPU_nametables
+class BackgroundCanvas {
+public:
+    static constexpr int Columns = 2 * 32; // tiles across
+    static constexpr int Rows = 2 * 240;   // pixels down
+
+    // Reads `tiles` tiles of the pixel row `row`, starting at the tile column `column` and wrapping around horizontally.
+    // The tiles are drawn with the pattern table at `patternAddr`.
+    void read(Bus& bus, std::uint16_t patternAddr, int row, int column, int tiles, std::uint8_t* pixels);
+
+    // The name table or attribute byte at `addr` ($2000-$2FFF) changed, as well as the ones mirrored with it.
+    void invalidate(std::uint16_t addr);
+    // Every tile may have changed.
+    void invalidateAll();
+
+private:
+    void drawTileRow(Bus& bus, int row, int column);
+
+    std::array<std::uint8_t, Columns * 8 * Rows> pixels{};
+
+    // The generation each row of each tile was drawn at, it is up to date when it matches.
+    std::array<std::uint32_t, Columns * Rows> drawn{};
+    std::uint32_t generation = 1;
+    std::uint16_t patternAddr = 0;
+};
+
+#endif // OCFBNJ_NES_BACKGROUND_CANVAS_H
@@ -6,6 +6,7 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <span>
 
 #include <nes/APU.h>
 #include <nes/CPU.h>
@@ -13,6 +14,8 @@
 #include <nes/Joypad.h>
 #include <nes/Mapper.h>
 #include <nes/PPU.h>
+#include <nes/PageTable.h>
+#include <nes/TileCache.h>
 #include <nes/literals.h>
 
 // CPU and PPU access memory (including memory-mapped spaces) through the bus.
@@ -20,11 +23,39 @@
 // Because it contains all the components of the NES system.
 class Bus {
 public:
-    Bus() = default;
+    // The outcome of running the console for a batch of master cycles.
+    // A master cycle is one PPU dot, the finest step the console is run at.
+    struct RunResult {
+        bool frameComplete = false; // the PPU completed a frame during the batch
+        std::uint64_t cycles = 0;   // master cycles actually run
+        std::uint32_t irqCount = 0; // IRQs requested by the APU and the mapper
+        std::uint32_t nmiCount = 0; // NMIs requested by the PPU
+    };
+
+    // How the PPU is kept in sync with the CPU.
+    enum class PpuSyncMode {
+        // The PPU is clocked on every master cycle and the CPU on every CPU cycle.
+        Lockstep,
+        // The PPU is left idle and caught up in bulk to the current master cycle when the CPU accesses
+        // something it can observe or affect ($2000-$3FFF, $4014, mapper registers),
+        // and when it reaches VBlank, a mapper scanline clock or the end of a frame.
+        // The CPU runs a whole instruction at a time and the master clock skips ahead to the next deadline.
+        CatchUp,
+        // Like CatchUp, with the PPU caught up on a thread of its own that trails the CPU.
+        // Writes to OAMADDR, OAMDATA, PPUSCROLL, PPUADDR and PPUDATA are queued with their master cycle,
+        // and the PPU is regularly told to run up to the current master cycle, so it runs alongside the CPU.
+        // The CPU only waits for it to catch up where CatchUp would observe the PPU: when it reads a PPU register,
+        // writes PPUCTRL, PPUMASK, OAMDMA or a mapper register, at PPU events, and when it falls too far behind.
+        Threaded,
+    };
+
+    Bus();
     Bus(const Bus&) = delete;
     Bus& operator=(const Bus&) = delete;
-    Bus(Bus&&) = default;
-    Bus& operator=(Bus&&) = default;
+    // The PPU thread holds a pointer to the bus.
+    Bus(Bus&&) = delete;
+    Bus& operator=(Bus&&) = delete;
+    ~Bus();
 
     void insert(Cartridge cartridge);
     void powerUp();
@@ -32,6 +63,7 @@ public:
     // CPU and PPU have different buses.
 
     // CPU read from and write to the MAIN bus.
+    // Accesses are timestamped with the current master cycle.
     std::uint8_t cpuRead(std::uint16_t addr);
     std::uint16_t cpuRead16(std::uint16_t addr);
     void cpuWrite(std::uint16_t addr, std::uint8_t data);
@@ -39,10 +71,29 @@ public:
     // PPU read from and write to the PPU bus.
     std::uint8_t ppuRead(std::uint16_t addr);
     void ppuWrite(std::uint16_t addr, std::uint8_t data);
+    // The decoded pattern table row whose low bit plane is at `addr`.
+    const TileCache::Row& ppuTileRow(std::uint16_t addr);
+    // A copy of the name tables and pattern tables as the PPU sees them now, for deferred rendering.
+    // The copy is shared until the PPU memory, the mirroring or the CHR banks change.
+    std::shared_ptr<const PPU::VideoMemory> ppuMemory();
+
+    // Interrupt lines, used by the other components instead of calling the CPU directly.
+    void nmi();
+    void irq();
+
+    // Mapper scanline counters are clocked through the bus, so that it knows when an IRQ may be raised.
+    void mapperScanline();
 
     void clock();
     void reset();
 
+    void setPpuSyncMode(PpuSyncMode mode);
+
+    // Runs until the PPU completes a frame.
+    RunResult runFrame();
+    // Runs exactly `cycles` master cycles.
+    RunResult runCycles(std::uint64_t cycles);
+
     void serialize(std::ostream& os) const;
     void deserialize(std::istream& is);
 
@@ -52,18 +103,116 @@ public:
     PPU& getPPU();
     Joypad& getJoypad1();
     Joypad& getJoypad2();
+    const PageTable& getCpuPages() const;
 
 private:
+    template <bool CatchUp>
+    void tick();
+
+    template <bool StopAtFrameEnd, bool CatchUp>
+    RunResult run(std::uint64_t cycles);
+
+    // Points the name tables at PPU RAM according to the mapper mirroring.
+    void mapNameTables();
+    // Resolves the pattern tables to CHR offsets according to the mapper CHR banks.
+    void mapChrPages();
+
+    // Makes the CPU run its first cycle at or after `cycle`, to take an interrupt latched while catching up.
+    void runCpuFrom(std::uint64_t cycle);
+
+    // Clocks the PPU up to and including the master cycle `cycle`.
+    void syncPpu(std::uint64_t cycle);
+    void updatePpuEventDeadline();
+    // Runs the PPU up to and including the master cycle `cycle`, on whichever thread owns it.
+    void runPpu(std::uint64_t cycle);
+    void writePpuRegister(std::uint16_t addr, std::uint8_t data);
+
+    // Clocks the APU up to, but not including, the master cycle `cycle`.
+    // Within a master cycle the APU is clocked after the CPU, so this is where a CPU access at `cycle` finds it.
+    void syncApu(std::uint64_t cycle);
+    void updateApuEventDeadline();
+
+    // An action for the PPU thread, in master cycle order.
+    struct PpuEvent {
+        enum class Kind : std::uint8_t {
+            Run,   // run up to and including `cycle`
+            Write, // run, then write `data` to the register at `addr`
+            Stop,
+        };
+
+        Kind kind = Kind::Run;
+        std::uint16_t addr = 0;
+        std::uint8_t data = 0;
+        std::uint64_t cycle = 0;
+    };
+
+    struct PpuThread;
+
+    void startPpuThread();
+    void stopPpuThread();
+    void pushPpuEvent(PpuEvent event);
+    // Blocks until the PPU thread has handled every event.
+    void waitPpu();
+    void ppuThreadLoop();
+
     // See https://bugzmanov.github.io/nes_ebook/images/ch2/image_5_motherboard.png
     std::unique_ptr<Mapper> mapper;
     CPU cpu;
     APU apu;
     PPU ppu;
     std::array<std::uint8_t, 2_kb> cpuRam{};
-    std::array<std::uint8_t, 2_kb> ppuRam{};
+    std::array<std::uint8_t, 4_kb> ppuRam{}; // the upper 2 KB are only used by four-screen cartridges
 
     Joypad joypad1;
     Joypad joypad2;
+
+    // The four logical name tables ($2000, $2400, $2800, $2C00) resolved to PPU RAM.
+    std::array<std::uint8_t*, 4> nameTables{};
+
+    // CPU RAM, PRG ROM and PRG RAM are read and written through the page table,
+    // everything else goes through the handlers in cpuRead and cpuWrite.
+    PageTable cpuPages;
+
+    // The pattern tables are read from CHR memory directly, at the offset of each 1 KB page.
+    std::span<const std::uint8_t> chr;
+    std::array<std::uint32_t, 8> chrPages{};
+    TileCache tileCache;
+
+    // The last copy handed out by ppuMemory(), and whether it is outdated.
+    std::shared_ptr<const PPU::VideoMemory> ppuMemoryCopy;
+    bool ppuMemoryChanged = true;
+    bool chrChanged = true;
+
+    // The master clock is counted in PPU dots.
+    // The PPU runs on every dot, the CPU on every third dot and the APU on every second CPU cycle.
+    static constexpr std::uint64_t PpuClockDivider = 1;
+    static constexpr std::uint64_t CpuClockDivider = 3;
+    static constexpr std::uint64_t ApuClockDivider = 6;
+
+    // Scheduler Begin
+    std::uint64_t masterCycle = 0;
+    std::uint64_t ppuDeadline = 0; // master cycle of the next PPU dot
+    std::uint64_t cpuDeadline = 0; // master cycle of the next CPU cycle (or instruction, when catching up)
+    std::uint64_t apuDeadline = 0; // master cycle of the next APU cycle
+    bool mapperIrqPending = false;
+    // Scheduler End
+
+    PpuSyncMode ppuSyncMode = PpuSyncMode::CatchUp;
+    std::uint64_t ppuEventDeadline = 0; // the PPU must be caught up at this master cycle
+    std::uint64_t apuEventDeadline = 0; // the APU must be caught up at this master cycle
+    bool ppuFrameComplete = false;
+
+    // The PPU thread, only in Threaded mode.
+    // The PPU state and ppuDeadline belong to it until the CPU waits for it.
+    std::unique_ptr<PpuThread> ppuThread;
+    std::uint64_t ppuRequested = 0; // ppuDeadline once the PPU thread has handled every event
+
+    // The PPU thread is told to run every few scanlines, and waited for when it trails by more than a bound.
+    static constexpr std::uint64_t PpuThreadStep = 4 * PPU::ScanlineCycles * PpuClockDivider;
+    static constexpr std::uint64_t PpuThreadMaxLag = 64 * PPU::ScanlineCycles * PpuClockDivider;
+
+    std::uint32_t irqCount = 0;
+    std::uint32_t nmiCount = 0;
 };
 
 #endif // OCFBNJ_NES_BUS_H
@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <istream>
 #include <ostream>
+#include <utility>
+#include <vector>
 
 class Bus;
 
@@ -18,10 +20,24 @@ public:
 
     void connect(Bus* bus);
 
+    // Runs a single cycle.
     void clock();
+    // Runs the next instruction, or the remaining cycles of the current one,
+    // and returns the number of cycles it takes.
+    std::uint8_t stepInstruction();
+
     void reset();
-    void nmi();
-    void irq();
+
+    // Decoded instructions are cached, the bus tells the CPU when the code they were decoded from may have changed.
+    // PRG ROM does not change, and switching its banks does not invalidate anything.
+    void invalidateRamCode(std::uint16_t addr);
+    void invalidateCode();
+
+    // When running cycle by cycle, interrupts are taken right away. When running whole instructions they are
+    // latched and taken by the next stepInstruction(), and true is returned so that the bus can run the CPU
+    // again on its next cycle, as clock() would have done.
+    bool nmi();
+    bool irq();
 
     void serialize(std::ostream& os) const;
     void deserialize(std::istream& is);
@@ -72,7 +88,37 @@ private:
         };
     };
 
+    using Handler = void (*)(CPU&, std::uint16_t operand);
+
+    // An instruction whose opcode and operand have been read and decoded.
+    struct DecodedInstruction {
+        Handler handler = nullptr;
+        std::uint64_t generation = 0; // the entry is valid while it matches the generation of its cache
+        const std::uint8_t* code = nullptr; // for PRG ROM, the byte of the bank the opcode was read from
+        std::uint16_t operand = 0;
+        std::uint8_t opcode = 0;
+        std::uint8_t length = 0;
+    };
+
     void step();
+    bool takeInterrupt();
+    void interrupt(std::uint16_t vector, std::uint8_t interruptCycles);
+
+    const DecodedInstruction& fetch();
+    void decode(DecodedInstruction& inst);
+
+    // Every opcode is compiled into its own handler, specialized on its addressing mode and instruction.
+    template <std::uint8_t Opcode>
+    static void execute(CPU& cpu, std::uint16_t operand);
+
+    template <std::size_t... Opcodes>
+    static constexpr std::array<Handler, sizeof...(Opcodes)> makeHandlers(std::index_sequence<Opcodes...>);
+
+    template <Addressing Mode>
+    std::uint16_t fetchAddress(std::uint16_t operand, bool& pageCrossed);
+
+    // Sets the zero and negative flags according to the value.
+    void updateZN(std::uint8_t value);
 
     std::uint8_t read(std::uint16_t addr);
     std::uint16_t read16(std::uint16_t addr);
@@ -88,6 +134,7 @@ private:
     // The function name is capitalized because we cannot use `and` as the function name.
     void ADC(std::uint16_t address);
     void AND(std::uint16_t address);
+    template <Addressing Mode>
     void ASL(std::uint16_t address);
     void BCC(std::uint16_t address);
     void BCS(std::uint16_t address);
@@ -118,6 +165,7 @@ private:
     void LDA(std::uint16_t address);
     void LDX(std::uint16_t address);
     void LDY(std::uint16_t address);
+    template <Addressing Mode>
     void LSR(std::uint16_t address);
     void NOP(std::uint16_t address);
     void ORA(std::uint16_t address);
@@ -125,7 +173,9 @@ private:
     void PHP(std::uint16_t address);
     void PLA(std::uint16_t address);
     void PLP(std::uint16_t address);
+    template <Addressing Mode>
     void ROL(std::uint16_t address);
+    template <Addressing Mode>
     void ROR(std::uint16_t address);
     void RTI(std::uint16_t address);
     void RTS(std::uint16_t address);
@@ -146,7 +196,265 @@ private:
 
     // Instruction Set
     // See https://www.masswerk.at/6502/6502_instruction_set.html
-    static std::array<Operation, 256> opTable;
+    static constexpr std::array<Operation, 256> opTable{
+        Operation{.name = "BRK", .addressing = Addressing::Imp, .instruction = &CPU::BRK, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "ORA", .addressing = Addressing::Izx, .instruction = &CPU::ORA, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zp0, .instruction = &CPU::NOP, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "ORA", .addressing = Addressing::Zp0, .instruction = &CPU::ORA, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "ASL", .addressing = Addressing::Zp0, .instruction = &CPU::ASL<Addressing::Zp0>, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "PHP", .addressing = Addressing::Imp, .instruction = &CPU::PHP, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "ORA", .addressing = Addressing::Imm, .instruction = &CPU::ORA, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "ASL", .addressing = Addressing::Acc, .instruction = &CPU::ASL<Addressing::Acc>, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abs, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ORA", .addressing = Addressing::Abs, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ASL", .addressing = Addressing::Abs, .instruction = &CPU::ASL<Addressing::Abs>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "BPL", .addressing = Addressing::Rel, .instruction = &CPU::BPL, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "ORA", .addressing = Addressing::Izy, .instruction = &CPU::ORA, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ORA", .addressing = Addressing::Zpx, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ASL", .addressing = Addressing::Zpx, .instruction = &CPU::ASL<Addressing::Zpx>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "CLC", .addressing = Addressing::Imp, .instruction = &CPU::CLC, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "ORA", .addressing = Addressing::Aby, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "ORA", .addressing = Addressing::Abx, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "ASL", .addressing = Addressing::Abx, .instruction = &CPU::ASL<Addressing::Abx>, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "JSR", .addressing = Addressing::Abs, .instruction = &CPU::JSR, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "AND", .addressing = Addressing::Izx, .instruction = &CPU::AND, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "BIT", .addressing = Addressing::Zp0, .instruction = &CPU::BIT, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "AND", .addressing = Addressing::Zp0, .instruction = &CPU::AND, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "ROL", .addressing = Addressing::Zp0, .instruction = &CPU::ROL<Addressing::Zp0>, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "PLP", .addressing = Addressing::Imp, .instruction = &CPU::PLP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "AND", .addressing = Addressing::Imm, .instruction = &CPU::AND, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "ROL", .addressing = Addressing::Acc, .instruction = &CPU::ROL<Addressing::Acc>, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "BIT", .addressing = Addressing::Abs, .instruction = &CPU::BIT, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "AND", .addressing = Addressing::Abs, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ROL", .addressing = Addressing::Abs, .instruction = &CPU::ROL<Addressing::Abs>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "BMI", .addressing = Addressing::Rel, .instruction = &CPU::BMI, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "AND", .addressing = Addressing::Izy, .instruction = &CPU::AND, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "AND", .addressing = Addressing::Zpx, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ROL", .addressing = Addressing::Zpx, .instruction = &CPU::ROL<Addressing::Zpx>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "SEC", .addressing = Addressing::Imp, .instruction = &CPU::SEC, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "AND", .addressing = Addressing::Aby, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "AND", .addressing = Addressing::Abx, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "ROL", .addressing = Addressing::Abx, .instruction = &CPU::ROL<Addressing::Abx>, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "RTI", .addressing = Addressing::Imp, .instruction = &CPU::RTI, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "EOR", .addressing = Addressing::Izx, .instruction = &CPU::EOR, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zp0, .instruction = &CPU::NOP, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "EOR", .addressing = Addressing::Zp0, .instruction = &CPU::EOR, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "LSR", .addressing = Addressing::Zp0, .instruction = &CPU::LSR<Addressing::Zp0>, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "PHA", .addressing = Addressing::Imp, .instruction = &CPU::PHA, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "EOR", .addressing = Addressing::Imm, .instruction = &CPU::EOR, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "LSR", .addressing = Addressing::Acc, .instruction = &CPU::LSR<Addressing::Acc>, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "JMP", .addressing = Addressing::Abs, .instruction = &CPU::JMP, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "EOR", .addressing = Addressing::Abs, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "LSR", .addressing = Addressing::Abs, .instruction = &CPU::LSR<Addressing::Abs>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "BVC", .addressing = Addressing::Rel, .instruction = &CPU::BVC, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "EOR", .addressing = Addressing::Izy, .instruction = &CPU::EOR, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "EOR", .addressing = Addressing::Zpx, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "LSR", .addressing = Addressing::Zpx, .instruction = &CPU::LSR<Addressing::Zpx>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "CLI", .addressing = Addressing::Imp, .instruction = &CPU::CLI, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "EOR", .addressing = Addressing::Aby, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "EOR", .addressing = Addressing::Abx, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "LSR", .addressing = Addressing::Abx, .instruction = &CPU::LSR<Addressing::Abx>, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "RTS", .addressing = Addressing::Imp, .instruction = &CPU::RTS, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "ADC", .addressing = Addressing::Izx, .instruction = &CPU::ADC, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zp0, .instruction = &CPU::NOP, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "ADC", .addressing = Addressing::Zp0, .instruction = &CPU::ADC, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "ROR", .addressing = Addressing::Zp0, .instruction = &CPU::ROR<Addressing::Zp0>, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "PLA", .addressing = Addressing::Imp, .instruction = &CPU::PLA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ADC", .addressing = Addressing::Imm, .instruction = &CPU::ADC, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "ROR", .addressing = Addressing::Acc, .instruction = &CPU::ROR<Addressing::Acc>, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "JMP", .addressing = Addressing::Ind, .instruction = &CPU::JMP, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "ADC", .addressing = Addressing::Abs, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ROR", .addressing = Addressing::Abs, .instruction = &CPU::ROR<Addressing::Abs>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "BVS", .addressing = Addressing::Rel, .instruction = &CPU::BVS, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "ADC", .addressing = Addressing::Izy, .instruction = &CPU::ADC, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ADC", .addressing = Addressing::Zpx, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "ROR", .addressing = Addressing::Zpx, .instruction = &CPU::ROR<Addressing::Zpx>, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "SEI", .addressing = Addressing::Imp, .instruction = &CPU::SEI, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "ADC", .addressing = Addressing::Aby, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "ADC", .addressing = Addressing::Abx, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "ROR", .addressing = Addressing::Abx, .instruction = &CPU::ROR<Addressing::Abx>, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "STA", .addressing = Addressing::Izx, .instruction = &CPU::STA, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "STY", .addressing = Addressing::Zp0, .instruction = &CPU::STY, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "STA", .addressing = Addressing::Zp0, .instruction = &CPU::STA, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "STX", .addressing = Addressing::Zp0, .instruction = &CPU::STX, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "DEY", .addressing = Addressing::Imp, .instruction = &CPU::DEY, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "TXA", .addressing = Addressing::Imp, .instruction = &CPU::TXA, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "STY", .addressing = Addressing::Abs, .instruction = &CPU::STY, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "STA", .addressing = Addressing::Abs, .instruction = &CPU::STA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "STX", .addressing = Addressing::Abs, .instruction = &CPU::STX, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "BCC", .addressing = Addressing::Rel, .instruction = &CPU::BCC, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "STA", .addressing = Addressing::Izy, .instruction = &CPU::STA, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "STY", .addressing = Addressing::Zpx, .instruction = &CPU::STY, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "STA", .addressing = Addressing::Zpx, .instruction = &CPU::STA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "STX", .addressing = Addressing::Zpy, .instruction = &CPU::STX, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpy, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "TYA", .addressing = Addressing::Imp, .instruction = &CPU::TYA, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "STA", .addressing = Addressing::Aby, .instruction = &CPU::STA, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "TXS", .addressing = Addressing::Imp, .instruction = &CPU::TXS, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "STA", .addressing = Addressing::Abx, .instruction = &CPU::STA, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "LDY", .addressing = Addressing::Imm, .instruction = &CPU::LDY, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "LDA", .addressing = Addressing::Izx, .instruction = &CPU::LDA, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "LDX", .addressing = Addressing::Imm, .instruction = &CPU::LDX, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "LDY", .addressing = Addressing::Zp0, .instruction = &CPU::LDY, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "LDA", .addressing = Addressing::Zp0, .instruction = &CPU::LDA, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "LDX", .addressing = Addressing::Zp0, .instruction = &CPU::LDX, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "TAY", .addressing = Addressing::Imp, .instruction = &CPU::TAY, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "LDA", .addressing = Addressing::Imm, .instruction = &CPU::LDA, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "TAX", .addressing = Addressing::Imp, .instruction = &CPU::TAX, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "LDY", .addressing = Addressing::Abs, .instruction = &CPU::LDY, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "LDA", .addressing = Addressing::Abs, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "LDX", .addressing = Addressing::Abs, .instruction = &CPU::LDX, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "BCS", .addressing = Addressing::Rel, .instruction = &CPU::BCS, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "LDA", .addressing = Addressing::Izy, .instruction = &CPU::LDA, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "LDY", .addressing = Addressing::Zpx, .instruction = &CPU::LDY, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "LDA", .addressing = Addressing::Zpx, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "LDX", .addressing = Addressing::Zpy, .instruction = &CPU::LDX, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpy, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "CLV", .addressing = Addressing::Imp, .instruction = &CPU::CLV, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "LDA", .addressing = Addressing::Aby, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "TSX", .addressing = Addressing::Imp, .instruction = &CPU::TSX, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "LDY", .addressing = Addressing::Abx, .instruction = &CPU::LDY, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "LDA", .addressing = Addressing::Abx, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "LDX", .addressing = Addressing::Aby, .instruction = &CPU::LDX, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "CPY", .addressing = Addressing::Imm, .instruction = &CPU::CPY, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "CMP", .addressing = Addressing::Izx, .instruction = &CPU::CMP, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "CPY", .addressing = Addressing::Zp0, .instruction = &CPU::CPY, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "CMP", .addressing = Addressing::Zp0, .instruction = &CPU::CMP, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "DEC", .addressing = Addressing::Zp0, .instruction = &CPU::DEC, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "INY", .addressing = Addressing::Imp, .instruction = &CPU::INY, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "CMP", .addressing = Addressing::Imm, .instruction = &CPU::CMP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "DEX", .addressing = Addressing::Imp, .instruction = &CPU::DEX, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "CPY", .addressing = Addressing::Abs, .instruction = &CPU::CPY, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "CMP", .addressing = Addressing::Abs, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "DEC", .addressing = Addressing::Abs, .instruction = &CPU::DEC, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "BNE", .addressing = Addressing::Rel, .instruction = &CPU::BNE, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "CMP", .addressing = Addressing::Izy, .instruction = &CPU::CMP, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "CMP", .addressing = Addressing::Zpx, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "DEC", .addressing = Addressing::Zpx, .instruction = &CPU::DEC, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "CLD", .addressing = Addressing::Imp, .instruction = &CPU::CLD, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "CMP", .addressing = Addressing::Aby, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "CMP", .addressing = Addressing::Abx, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "DEC", .addressing = Addressing::Abx, .instruction = &CPU::DEC, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "CPX", .addressing = Addressing::Imm, .instruction = &CPU::CPX, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Izx, .instruction = &CPU::SBC, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "CPX", .addressing = Addressing::Zp0, .instruction = &CPU::CPX, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Zp0, .instruction = &CPU::SBC, .cycle = 3, .pageCycle = 0},
+        Operation{.name = "INC", .addressing = Addressing::Zp0, .instruction = &CPU::INC, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
+        Operation{.name = "INX", .addressing = Addressing::Imp, .instruction = &CPU::INX, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Imm, .instruction = &CPU::SBC, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Imm, .instruction = &CPU::SBC, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "CPX", .addressing = Addressing::Abs, .instruction = &CPU::CPX, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Abs, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "INC", .addressing = Addressing::Abs, .instruction = &CPU::INC, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "BEQ", .addressing = Addressing::Rel, .instruction = &CPU::BEQ, .cycle = 2, .pageCycle = 1},
+        Operation{.name = "SBC", .addressing = Addressing::Izy, .instruction = &CPU::SBC, .cycle = 5, .pageCycle = 1},
+        Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Zpx, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 0},
+        Operation{.name = "INC", .addressing = Addressing::Zpx, .instruction = &CPU::INC, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
+        Operation{.name = "SED", .addressing = Addressing::Imp, .instruction = &CPU::SED, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "SBC", .addressing = Addressing::Aby, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "SBC", .addressing = Addressing::Abx, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 1},
+        Operation{.name = "INC", .addressing = Addressing::Abx, .instruction = &CPU::INC, .cycle = 7, .pageCycle = 0},
+        Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
+    };
+    static const std::array<Handler, 256> handlers;
 
     // The following member variables are CPU components, they can be used to serialize and deserialize.
 
@@ -162,10 +470,23 @@ private:
     StatusRegister status{.reg = 0x24};
 
     std::uint8_t cycles = 8;
+
+    bool nmiPending = false;
+    bool irqPending = false;
     // CPU Components End
 
     Bus* bus = nullptr;
 
+    bool latchInterrupts = false; // set by stepInstruction(), cleared by clock()
+
+    // Decoded instruction caches for PRG ROM ($8000-$FFFF), keyed by PC and the mapped PRG bank,
+    // and for CPU RAM ($0000-$07FF), invalidated on writes.
+    std::vector<DecodedInstruction> prgCodeCache = std::vector<DecodedInstruction>(0x8000);
+    std::vector<DecodedInstruction> ramCodeCache = std::vector<DecodedInstruction>(0x0800);
+    std::uint64_t prgCodeGeneration = 1;
+    std::uint64_t ramCodeGeneration = 1;
+    DecodedInstruction uncachedInstruction;
+
     // for convenience
     std::uint8_t opcode = 0;
 
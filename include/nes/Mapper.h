@@ -5,8 +5,10 @@
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <span>
 
 #include <nes/Cartridge.h>
+#include <nes/PageTable.h>
 
 // Mapper is an interface that provide access to extended ROM memory(both CHR ROM and PRG ROM).
 // See https://bugzmanov.github.io/nes_ebook/chapter_5.html
@@ -23,8 +25,20 @@ public:
     virtual std::uint8_t ppuRead(std::uint16_t addr) = 0;
     virtual void ppuWrite(std::uint16_t addr, std::uint8_t data) = 0;
 
+    // Offset in CHR ROM (or CHR RAM) of a pattern table address with the CHR banks currently selected.
+    // Banks are never smaller than 1 KB, so an offset holds for the whole 1 KB the address is in.
+    virtual std::uint32_t chrOffset(std::uint16_t addr) const = 0;
+    // CHR ROM (or CHR RAM), for the bus to read the pattern tables through chrOffset.
+    std::span<const std::uint8_t> chr() const;
+
     virtual void reset();
 
+    // Gives the mapper the CPU page table to point at its PRG banks.
+    void connect(PageTable* cpuPages);
+    // Maps the PRG banks currently selected into the CPU page table.
+    // Mappers call it whenever they switch banks, by default the cartridge space is left to cpuRead/cpuWrite.
+    virtual void mapPrgPages();
+
     virtual void serialize(std::ostream& os) const;
     virtual void deserialize(std::istream& is);
 
@@ -33,6 +47,8 @@ public:
     virtual bool irqState() const;
     virtual void irqClear();
 
+    // Whether scanline() does anything, i.e. the mapper has a scanline counter.
+    virtual bool countsScanlines() const;
     virtual void scanline();
 
 protected:
@@ -40,6 +56,7 @@ protected:
     std::uint8_t chrBanks() const;
 
     Cartridge cartridge;
+    PageTable* cpuPages = nullptr;
 };
 
 #endif // OCFBNJ_NES_MAPPER_H
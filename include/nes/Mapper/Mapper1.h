@@ -15,6 +15,9 @@ public:
 
     std::uint8_t ppuRead(std::uint16_t addr) override;
     void ppuWrite(std::uint16_t addr, std::uint8_t data) override;
+    std::uint32_t chrOffset(std::uint16_t addr) const override;
+
+    void mapPrgPages() override;
 
     void reset() override;
 
@@ -27,6 +30,7 @@ private:
     std::array<std::uint8_t, 8_kb> prgRam{};
 
     std::uint8_t loadRegister = 0;
+    std::uint8_t loadCount = 0;
     std::uint8_t controlRegister = 0x1C;
 
     std::uint8_t chrBank0 = 0;
@@ -15,6 +15,9 @@ public:
 
     std::uint8_t ppuRead(std::uint16_t addr) override;
     void ppuWrite(std::uint16_t addr, std::uint8_t data) override;
+    std::uint32_t chrOffset(std::uint16_t addr) const override;
+
+    void mapPrgPages() override;
 
     void reset() override;
 
@@ -26,6 +29,7 @@ public:
     bool irqState() const override;
     void irqClear() override;
 
+    bool countsScanlines() const override;
     void scanline() override;
 
 private:
@@ -7,7 +7,8 @@ enum class Mirroring {
     OneScreenLoBank,
     OneScreenUpBank,
     Vertical,
-    Horizontal
+    Horizontal,
+    FourScreen
 };
 
 std::string_view description(Mirroring mirroring);
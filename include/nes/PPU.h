@@ -6,10 +6,14 @@
 #include <cstdint>
 #include <functional>
 #include <istream>
+#include <memory>
 #include <ostream>
 #include <span>
 #include <vector>
 
+#include <nes/BackgroundCanvas.h>
+#include <nes/WorkerPool.h>
+
 class Bus;
 
 class PPU {
@@ -21,33 +25,67 @@ public:
         std::uint8_t a;
     };
 
+    // Frame is rendered as color indices into the system palette, one byte per pixel.
+    // RGBA pixels are only expanded from them when they are asked for.
     class Frame {
     public:
-        std::span<const std::uint8_t> getRawPixels() const {
-            return std::span{reinterpret_cast<const std::uint8_t*>(pixels.data()), Width * Height * sizeof(Pixel)};
+        // Pixels that have not been rendered since power up, expanded to transparent black.
+        static constexpr std::uint8_t Blank = 0xFF;
+
+        // The color index (0-63, or Blank) of every pixel, row by row from the top.
+        std::span<const std::uint8_t> getIndices() const {
+            return indices;
         }
 
+        // RGBA pixels, row by row from the bottom.
+        std::span<const std::uint8_t> getRawPixels() const;
+
+        // FNV-1a of the RGBA pixels, so that frames can be compared without storing them.
+        std::uint64_t hash() const;
+
         Pixel getPixel(int x, int y) const {
             assert(x >= 0 && x < Width);
             assert(y >= 0 && y < Height);
 
-            y = Height - y - 1;
-            return pixels[y * Width + x];
+            std::uint8_t index = indices[y * Width + x];
+            return index < defaultPalette.size() ? defaultPalette[index] : Pixel{};
         }
 
-        void setPixel(int x, int y, Pixel pixel) {
+        void setPixel(int x, int y, std::uint8_t index) {
             assert(x >= 0 && x < Width);
             assert(y >= 0 && y < Height);
 
-            y = Height - y - 1;
-            pixels[y * Width + x] = pixel;
+            indices[y * Width + x] = index;
+            expanded = false;
+        }
+
+        // The color indices of row y, for a scanline that is drawn at once.
+        std::span<std::uint8_t> getRow(int y) {
+            assert(y >= 0 && y < Height);
+
+            expanded = false;
+            return std::span{indices}.subspan(y * Width, Width);
         }
 
     private:
         static constexpr auto Width = 256;
         static constexpr auto Height = 240;
 
-        std::array<Pixel, Width * Height> pixels{};
+        std::array<std::uint8_t, Width * Height> indices = [] {
+            std::array<std::uint8_t, Width * Height> blank;
+            blank.fill(Blank);
+            return blank;
+        }();
+
+        mutable std::array<Pixel, Width * Height> pixels{};
+        mutable bool expanded = false;
+    };
+
+    // The name tables and pattern tables as the PPU fetches them, copied for deferred rendering.
+    struct VideoMemory {
+        std::array<std::uint8_t, 0x1000> nameTables{}; // $2000-$2FFF with the mirroring applied
+        std::array<std::uint32_t, 8> chrPages{};       // offset in chr of each 1 KB of the pattern tables
+        std::shared_ptr<const std::vector<std::uint8_t>> chr;
     };
 
     PPU() = default;
@@ -58,7 +96,12 @@ public:
 
     void connect(Bus* bus);
 
+    static constexpr int ScanlineCycles = 341;
+
     void clock();
+    // Runs `cycles` cycles, whole scanlines and idle stretches at a time where possible.
+    // Equivalent to calling clock() as many times, provided nothing accesses the PPU in the meantime.
+    void run(int cycles);
     void reset();
 
     std::uint8_t readStatus();
@@ -79,12 +122,54 @@ public:
     void serialize(std::ostream& os) const;
     void deserialize(std::istream& is);
 
-    const Frame& getFrame() const;
+    const Frame& getFrame();
     bool isFrameComplete() const;
 
+    // Frames rendered while skipping are not drawn, the frame keeps the last pixels drawn.
+    // Everything the game can observe is still computed: sprite 0 hit, sprite overflow, VBlank and mapper clocks.
+    void setFrameSkipping(bool skipping);
+
+    // Visible scanlines that are run in bulk are drawn later by worker threads,
+    // from a copy of the state they start from and of the memory they fetch.
+    // Sprite 0 hits are still found by the PPU as it runs. getFrame() waits for the pending scanlines.
+    // A frame being skipped is not drawn at all.
+    void setDeferredRendering(bool deferred);
+
+    // The background of the scanlines rendered in bulk is read from a canvas of the four name tables,
+    // which is kept from one frame to the next, instead of fetching every tile of every scanline.
+    void setBackgroundCanvas(bool enabled);
+    // The name tables or the pattern tables were remapped by the mapper or restored by the bus.
+    void invalidateBackground();
+
+    // Number of cycles until the PPU does something the rest of the console can observe
+    // without accessing its registers: setting VBlank (and raising an NMI), clocking the mapper
+    // scanline counter (only counted with `mapperScanlines`), or completing a frame.
+    // 0 means the next cycle is such an event.
+    int cyclesUntilEvent(bool mapperScanlines) const;
+
     Pixel getColor(std::uint8_t palette, std::uint8_t pixel);
 
 private:
+    // Cycles 0-256 of a visible scanline, where all of its pixels are output.
+    static constexpr int ScanlineRenderCycles = 257;
+
+    // Whether renderScanline() can run, i.e. the PPU is at the start of a visible scanline.
+    bool atVisibleScanlineStart() const;
+    // Runs the first ScanlineRenderCycles cycles of a visible scanline in a single pass.
+    void renderScanline();
+
+    // Whether skipScanline() can run, i.e. the PPU is at the start of a visible or pre-render scanline
+    // with rendering disabled.
+    bool atIdleScanlineStart() const;
+    // Runs a whole scanline with rendering disabled in a single step.
+    void skipScanline();
+
+    // Number of cycles from now on where clock() would only count cycles:
+    // the post-render scanline and vertical blanking, except for setting VBlank and completing the frame.
+    int idleCycles() const;
+    // Counts `cycles` cycles at once, at most idleCycles().
+    void skipIdleCycles(int cycles);
+
     std::uint8_t read(std::uint16_t addr);
     void write(std::uint16_t addr, std::uint8_t data);
 
@@ -95,8 +180,18 @@ private:
     void transferHorizontalBits();
     void transferVerticalBits();
 
+    // Resolves all the colors of the palette table, after it is replaced or greyscale is toggled.
+    void updateColors();
+    void updateColor(std::uint8_t index);
+
+    // The bytes of the next background tile, which are fetched over 8 cycles.
+    void fetchTile();
     void loadShifters();
     void updateShifters();
+    // Counts down the X counters of all the sprites at once, and shifts the sprites that reached 0.
+    void updateSpriteShifters();
+    // The first sprite drawn at the current dot with an opaque pixel, or -1.
+    int firstOpaqueSprite() const;
 
     void visibleFrameAndPreRender();
     void verticalBlanking();
@@ -104,6 +199,8 @@ private:
     void incrementCycle();
 
     void secondaryOamClearAndSpriteEvaluation();
+    // Buckets the sprites of primary OAM into the scanlines they cover.
+    void updateScanlineSprites();
     void calculateSpritesPatternAddr();
 
     void processMapper();
@@ -260,6 +357,71 @@ private:
     // Initially the maximum value is 8, doubled to eliminate flicker.
     constexpr static auto MaximumSpriteCount = 8 * 2;
 
+    // The pixels of a visible scanline before they are composed, see renderScanline().
+    struct ScanlinePixels {
+        // The background as palette << 2 | pixel, starting with the tile already in the shifters.
+        // The pixel drawn at x is bg[x + fineX], which is the bit that the shifters present at x.
+        std::array<std::uint8_t, 8 + 256> bg{};
+        // The sprites laid out along the scanline, the one with the lowest index wins.
+        std::array<std::uint8_t, 256> fg{};
+        std::array<std::uint8_t, 256> fgAttributes{};
+        std::array<bool, 256> fgSprite0{};
+    };
+
+    // Everything renderScanline() draws from, copied for a worker to draw the scanline later.
+    struct DeferredScanline {
+        std::span<std::uint8_t> row;
+        std::shared_ptr<const VideoMemory> memory;
+
+        ControlRegister control;
+        MaskRegister mask;
+        LoopyRegister vramAddr;
+        std::uint8_t fineX;
+
+        std::uint8_t bgAtByte;
+        std::uint8_t bgTileByteLo;
+        std::uint8_t bgTileByteHi;
+        std::uint16_t bgPatternShifterLo;
+        std::uint16_t bgPatternShifterHi;
+        std::uint16_t bgAttributeShifterLo;
+        std::uint16_t bgAttributeShifterHi;
+
+        std::array<std::uint8_t, MaximumSpriteCount * 4> secondaryOamData;
+        std::array<std::uint8_t, MaximumSpriteCount> spritePatternShifterLo;
+        std::array<std::uint8_t, MaximumSpriteCount> spritePatternShifterHi;
+        std::array<std::uint8_t, MaximumSpriteCount> spriteCounterX;
+        std::uint8_t spriteCount;
+
+        std::array<std::uint8_t, 32> colors;
+    };
+
+    // Scanlines are handed to the workers in groups, so that waking them up costs less than drawing.
+    static constexpr int DeferredScanlineGroup = 16;
+
+    // The 8 background pixels already in the shifters.
+    static void layoutShifters(ScanlinePixels& pixels, std::uint16_t patternLo, std::uint16_t patternHi, std::uint16_t attributeLo, std::uint16_t attributeHi);
+    // The sprites evaluated on the previous scanline, each drawn from its X counter on.
+    static void layoutSprites(ScanlinePixels& pixels,
+                              const std::uint8_t* secondaryOam,
+                              const std::uint8_t* patternLo,
+                              const std::uint8_t* patternHi,
+                              const std::uint8_t* counterX,
+                              int count);
+    // Composes the pixels of a scanline into `row` (if not empty), returns whether sprite 0 hits.
+    static bool composeScanline(const ScanlinePixels& pixels,
+                                MaskRegister mask,
+                                std::uint8_t fineX,
+                                bool sprite0HitPossible,
+                                const std::array<std::uint8_t, 32>& colors,
+                                std::span<std::uint8_t> row);
+    // Draws a scanline the way renderScanline() would have, on a worker thread.
+    static void drawDeferredScanline(const DeferredScanline& deferred);
+
+    void deferScanline();
+    void submitDeferredScanlines();
+    // Waits for the workers to draw every scanline deferred so far.
+    void finishDeferredScanlines();
+
     static std::array<PPU::Pixel, 64> defaultPalette;
 
     // The following member variables are PPU components, they can be used to serialize and deserialize.
@@ -300,14 +462,34 @@ private:
     std::array<std::uint8_t, MaximumSpriteCount * 4> secondaryOamData{};
     std::array<std::uint8_t, MaximumSpriteCount> spritePatternShifterLo{};
     std::array<std::uint8_t, MaximumSpriteCount> spritePatternShifterHi{};
+    std::array<std::uint8_t, MaximumSpriteCount> spriteCounterX{}; // dots left before each sprite is drawn
     std::uint8_t spriteCount = 0;
     bool sprite0HitPossible = false;
     // PPU Components End
 
     Bus* bus = nullptr;
 
+    // The palette table resolved to color indices, indexed by (palette << 2) | pixel.
+    // Kept up to date by writePalette() and writeMask(), so pixels are a single lookup.
+    std::array<std::uint8_t, 32> colors{};
+
+    // The sprites on each visible scanline, in OAM order, derived from the sprite Y positions and height.
+    // One more than MaximumSpriteCount is kept to tell whether the scanline overflows.
+    // Rebuilt on the first evaluation after OAM or the sprite height changes.
+    std::array<std::array<std::uint8_t, MaximumSpriteCount + 1>, 240> scanlineSprites{};
+    std::array<std::uint8_t, 240> scanlineSpriteCount{};
+    bool scanlineSpritesOutdated = true;
+
     bool frameComplete = false;
+    bool frameSkipping = false;
     Frame frame;
+
+    std::unique_ptr<BackgroundCanvas> backgroundCanvas;
+
+    // Deferred rendering, workers exist only while it is enabled.
+    // Declared after the frame, so that the workers finish drawing before it goes away.
+    std::vector<DeferredScanline> deferredScanlines;
+    std::unique_ptr<WorkerPool> renderWorkers;
 };
 
 #endif // OCFBNJ_NES_PPU_H
@@ -0,0 +1,22 @@
+#ifndef OCFBNJ_NES_PAGE_TABLE_H
+#define OCFBNJ_NES_PAGE_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// PageTable maps the CPU address space, in 256-byte pages, to memory that can be accessed directly.
+// Pages without a pointer need a handler: PPU, APU and I/O registers, mapper registers.
+struct PageTable {
+    static constexpr std::size_t PageSize = 0x100;
+    static constexpr std::size_t PageCount = 0x100;
+
+    // Maps [addr, addr + size) to the memory. A nullptr leaves the pages to the handlers.
+    void mapRead(std::uint16_t addr, std::size_t size, const std::uint8_t* memory);
+    void mapWrite(std::uint16_t addr, std::size_t size, std::uint8_t* memory);
+
+    std::array<const std::uint8_t*, PageCount> read{};
+    std::array<std::uint8_t*, PageCount> write{};
+};
+
+#endif // OCFBNJ_NES_PAGE_TABLE_H
@@ -0,0 +1,91 @@
+#ifndef OCFBNJ_NES_SPSC_QUEUE_H
+#define OCFBNJ_NES_SPSC_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+// SpscQueue is a bounded lock-free queue between exactly one producer thread and one consumer thread.
+// Neither side ever blocks, push() fails when the queue is full and pop() when it is empty.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+    // Producer only.
+    bool push(const T& item) {
+        const std::size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        items[tail % Capacity] = item;
+        this->tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Producer only, pushes as many items as there is room for and returns how many.
+    std::size_t push(std::span<const T> items) {
+        const std::size_t tail = this->tail.load(std::memory_order_relaxed);
+        const std::size_t count = std::min(items.size(), Capacity - (tail - head.load(std::memory_order_acquire)));
+
+        for (std::size_t i = 0; i != count; i++) {
+            this->items[(tail + i) % Capacity] = items[i];
+        }
+        this->tail.store(tail + count, std::memory_order_release);
+
+        return count;
+    }
+
+    // Consumer only.
+    bool pop(T& item) {
+        const std::size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = items[head % Capacity];
+        this->head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer only, pops as many items as there are and fit, and returns how many.
+    std::size_t pop(std::span<T> items) {
+        const std::size_t head = this->head.load(std::memory_order_relaxed);
+        const std::size_t count = std::min(items.size(), tail.load(std::memory_order_acquire) - head);
+
+        for (std::size_t i = 0; i != count; i++) {
+            items[i] = this->items[(head + i) % Capacity];
+        }
+        this->head.store(head + count, std::memory_order_release);
+
+        return count;
+    }
+
+    // Consumer only, drops every item.
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+
+    // Either side, exact only when the other side is idle.
+    std::size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> items{};
+
+    // Kept on separate cache lines, so that the two threads do not invalidate each other's line on every item.
+    alignas(64) std::atomic<std::size_t> head = 0; // next item to pop
+    alignas(64) std::atomic<std::size_t> tail = 0; // next item to push
+};
+
+#endif // OCFBNJ_NES_SPSC_QUEUE_H
@@ -0,0 +1,46 @@
+#ifndef OCFBNJ_NES_TILE_CACHE_H
+#define OCFBNJ_NES_TILE_CACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// TileCache holds the rows of the CHR tiles decoded into pixel indices (0-3), left to right.
+// Rows are keyed by their offset in CHR ROM (or CHR RAM) rather than by pattern table address,
+// so switching CHR banks only changes which rows are looked up.
+// Rows are decoded on first use and decoded again after a write to CHR RAM.
+// See https://www.nesdev.org/wiki/PPU_pattern_tables
+class TileCache {
+public:
+    using Row = std::array<std::uint8_t, 8>;
+
+    // Drops every row and sizes the cache for the CHR memory.
+    void reset(std::span<const std::uint8_t> chr);
+
+    // The row whose low bit plane is at `offset` (bit 3 clear), its high bit plane is 8 bytes further.
+    const Row& row(std::span<const std::uint8_t> chr, std::uint32_t offset) {
+        std::size_t index = (offset >> 4 << 3) | (offset & 0x07);
+
+        if (!valid[index]) {
+            rows[index] = decode(chr[offset], chr[offset + 8]);
+            valid[index] = true;
+        }
+
+        return rows[index];
+    }
+
+    // The CHR byte at `offset` changed.
+    void invalidate(std::uint32_t offset) {
+        valid[(offset >> 4 << 3) | (offset & 0x07)] = false;
+    }
+
+    static Row decode(std::uint8_t lo, std::uint8_t hi);
+
+private:
+    std::vector<Row> rows;
+    std::vector<bool> valid;
+};
+
+#endif // OCFBNJ_NES_TILE_CACHE_H
@@ -0,0 +1,42 @@
+#ifndef OCFBNJ_NES_WORKER_POOL_H
+#define OCFBNJ_NES_WORKER_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+// WorkerPool runs tasks on a fixed set of threads, in no particular order.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkerPool(unsigned threads);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    // Runs the tasks left before stopping the threads.
+    ~WorkerPool();
+
+    void push(Task task);
+    // Blocks until every task pushed so far has run.
+    void wait();
+
+private:
+    void work();
+
+    std::vector<std::thread> threads;
+
+    std::queue<Task> que;
+    std::mutex mtx;
+
+    // Released once per task, and once per thread to stop it.
+    std::counting_semaphore<> queued{0};
+    // Tasks pushed and not run yet.
+    std::atomic<std::size_t> unfinished = 0;
+};
+
+#endif // OCFBNJ_NES_WORKER_POOL_H
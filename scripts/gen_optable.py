@@ -157,20 +157,26 @@ def get_result(names, addressing_modes, instructions, cycles, page_cycles):
              "JSR", "LDA", "LDX", "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL", "ROR", "RTI", "RTS",
              "SBC", "SEC", "SED", "SEI", "STA", "STX", "STY", "TAX", "TAY", "TSX", "TXA", "TXS", "TYA"]
 
-    res = ""
+    # instructions with an accumulator form are specialized on their addressing mode
+    templated = ["ASL", "LSR", "ROL", "ROR"]
+
+    res = "static constexpr std::array<Operation, 256> opTable{\n"
     for i in range(256):
         if names[i].strip() not in table:
             names[i] = "???"
             instructions[i] = "&CPU::NIL"
+        elif names[i].strip() in templated:
+            instructions[i] += f"<Addressing::{addressing_modes[i].strip()}>"
 
-        # {"BRK", Imp, &CPU::BRK, 0, 0},
-        res += f'Operation{{.name = "{names[i].strip()}", .addressing = Addressing::{addressing_modes[i].strip()}, .instruction = {instructions[i].strip()}, .cycle = {cycles[i].strip()}, .pageCycle = {page_cycles[i].strip()}}},\n'
+        # Operation{.name = "BRK", .addressing = Addressing::Imp, .instruction = &CPU::BRK, .cycle = 7, .pageCycle = 0},
+        res += f'    Operation{{.name = "{names[i].strip()}", .addressing = Addressing::{addressing_modes[i].strip()}, .instruction = {instructions[i].strip()}, .cycle = {cycles[i].strip()}, .pageCycle = {page_cycles[i].strip()}}},\n'
+    res += "};"
     return res
 
 
-# Generate the CPU operation table in C++.
+# Generate the CPU operation table in C++, CPU::opTable in include/nes/CPU.h.
 # struct Operation {
-#     std::string_view name;
+#     const char* name;
 #     Addressing addressing;
 #     void (CPU::*instruction)(std::uint16_t);
 #     std::uint8_t cycle;
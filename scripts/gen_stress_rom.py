@@ -0,0 +1,427 @@
+import random
+import struct
+import sys
+
+# Generates test/mmc3_stress.nes, the MMC3 (mapper 4) ROM used by test/testBus.cpp.
+#
+# After filling the name tables, the palette and a shadow OAM with pseudo-random data, it turns on rendering,
+# NMIs, the APU and the MMC3 scanline IRQ, then loops over random actions separated by random delays,
+# so that they land anywhere in the frame:
+#   - PPUSCROLL writes, PPUMASK toggles (rendering on and off mid-frame);
+#   - PPUSTATUS and OAMDATA reads, polling for the sprite 0 hit, then a scroll split;
+#   - OAMADDR/OAMDATA writes;
+#   - MMC3 bank switches (CHR and PRG) and mirroring changes;
+#   - PPUCTRL writes (NMI stays enabled) and APU pulse period writes;
+#   - palette writes, with NMIs, IRQs and rendering off around PPUADDR/PPUDATA.
+# The NMI handler does an OAM DMA, moves the sprites, sets the scroll and the name table, and writes the APU.
+# The IRQ handler (MMC3 scanline counter and APU frame counter) acknowledges the MMC3 IRQ, sets the scroll,
+# switches a CHR bank and reloads the counter with a random scanline.
+#
+# usage: python gen_stress_rom.py <file.nes>
+
+OPS = {
+    # name: {mode: opcode}
+    "ADC": {"imm": 0x69, "zp": 0x65, "zpx": 0x75, "abs": 0x6D, "abx": 0x7D, "aby": 0x79, "izx": 0x61, "izy": 0x71},
+    "AND": {"imm": 0x29, "zp": 0x25, "zpx": 0x35, "abs": 0x2D, "abx": 0x3D, "aby": 0x39, "izx": 0x21, "izy": 0x31},
+    "ASL": {"acc": 0x0A, "zp": 0x06, "zpx": 0x16, "abs": 0x0E, "abx": 0x1E},
+    "BIT": {"zp": 0x24, "abs": 0x2C},
+    "BPL": {"rel": 0x10}, "BMI": {"rel": 0x30}, "BVC": {"rel": 0x50}, "BVS": {"rel": 0x70},
+    "BCC": {"rel": 0x90}, "BCS": {"rel": 0xB0}, "BNE": {"rel": 0xD0}, "BEQ": {"rel": 0xF0},
+    "CLC": {"imp": 0x18}, "SEC": {"imp": 0x38}, "CLI": {"imp": 0x58}, "SEI": {"imp": 0x78}, "CLD": {"imp": 0xD8},
+    "DEC": {"zp": 0xC6, "abs": 0xCE},
+    "EOR": {"imm": 0x49, "zp": 0x45, "abs": 0x4D},
+    "INC": {"zp": 0xE6, "zpx": 0xF6, "abs": 0xEE, "abx": 0xFE},
+    "JMP": {"abs": 0x4C, "ind": 0x6C},
+    "LDA": {"imm": 0xA9, "zp": 0xA5, "zpx": 0xB5, "abs": 0xAD, "abx": 0xBD, "aby": 0xB9, "izx": 0xA1, "izy": 0xB1},
+    "LDX": {"imm": 0xA2, "zp": 0xA6, "abs": 0xAE},
+    "LDY": {"imm": 0xA0, "zp": 0xA4, "abs": 0xAC},
+    "ORA": {"imm": 0x09, "zp": 0x05, "abs": 0x0D},
+    "TAX": {"imp": 0xAA}, "TXA": {"imp": 0x8A}, "DEX": {"imp": 0xCA}, "INX": {"imp": 0xE8},
+    "TAY": {"imp": 0xA8}, "TYA": {"imp": 0x98}, "DEY": {"imp": 0x88}, "INY": {"imp": 0xC8},
+    "RTI": {"imp": 0x40},
+    "STA": {"zp": 0x85, "zpx": 0x95, "abs": 0x8D, "abx": 0x9D, "aby": 0x99, "izx": 0x81, "izy": 0x91},
+    "TXS": {"imp": 0x9A}, "PHA": {"imp": 0x48}, "PLA": {"imp": 0x68},
+}
+SIZE = {"imp": 1, "acc": 1, "imm": 2, "zp": 2, "zpx": 2, "zpy": 2, "rel": 2, "izx": 2, "izy": 2, "abs": 3, "abx": 3, "aby": 3, "ind": 3}
+
+# zero page
+SEED = 0x00
+FRAME = 0x02
+TMP = 0x03
+PTR = 0x05
+SCRX = 0x07
+SCRY = 0x08
+CTRL = 0x09
+MASK = 0x0A
+
+
+# A tiny 6502 assembler: a.lda("imm", 0x80), a.bne("rel", "label"), a.jmp("abs", "label").
+class Asm:
+    def __init__(self, org):
+        self.org = org
+        self.code = []
+        self.labels = {}
+        self.fix = []
+
+    def pc(self):
+        return self.org + len(self.code)
+
+    def label(self, name):
+        self.labels[name] = self.pc()
+
+    def byte(self, *values):
+        self.code += list(values)
+
+    def __getattr__(self, name):
+        op = name.upper()
+        if op not in OPS:
+            raise AttributeError(name)
+
+        def emit(mode="imp", arg=None):
+            if mode in ("imp", "acc") and mode not in OPS[op]:
+                mode = "acc" if "acc" in OPS[op] else "imp"
+            self.code.append(OPS[op][mode])
+            if mode == "rel":
+                self.fix.append(("rel", len(self.code), arg))
+                self.code.append(0)
+            elif SIZE[mode] == 2:
+                self.code.append(arg & 0xFF)
+            elif SIZE[mode] == 3:
+                if isinstance(arg, str):
+                    self.fix.append(("abs", len(self.code), arg))
+                    self.code += [0, 0]
+                else:
+                    self.code += [arg & 0xFF, (arg >> 8) & 0xFF]
+
+        return emit
+
+    def resolve(self):
+        for kind, pos, name in self.fix:
+            target = self.labels[name]
+            if kind == "abs":
+                self.code[pos] = target & 0xFF
+                self.code[pos + 1] = target >> 8
+            else:
+                offset = target - (self.org + pos + 1)
+                assert -128 <= offset <= 127, (name, offset)
+                self.code[pos] = offset & 0xFF
+        return bytearray(self.code)
+
+
+def rng(a):
+    # 8-bit Galois LFSR in SEED -> A
+    a.lda("zp", SEED)
+    a.asl("acc")
+    name = f"r{len(a.code)}"
+    a.bcc("rel", name)
+    a.eor("imm", 0x1D)
+    a.label(name)
+    a.sta("zp", SEED)
+
+
+def build(seed):
+    a = Asm(0xE000)
+
+    a.label("reset")
+    a.sei()
+    a.cld()
+    a.ldx("imm", 0xFF)
+    a.txs()
+    a.lda("imm", 0)
+    a.sta("abs", 0x2000)
+    a.sta("abs", 0x2001)
+
+    # MMC3 banks, vertical mirroring
+    for r, v in enumerate([0, 2, 4, 5, 6, 7, 0, 1]):
+        a.lda("imm", r)
+        a.sta("abs", 0x8000)
+        a.lda("imm", v)
+        a.sta("abs", 0x8001)
+    a.lda("imm", 0)
+    a.sta("abs", 0xA000)
+
+    # wait for the PPU to warm up
+    a.label("vw1")
+    a.bit("abs", 0x2002)
+    a.bpl("rel", "vw1")
+    a.label("vw2")
+    a.bit("abs", 0x2002)
+    a.bpl("rel", "vw2")
+    a.lda("imm", seed & 0xFF | 1)
+    a.sta("zp", SEED)
+
+    # name tables $2000-$2FFF
+    a.lda("imm", 0x20)
+    a.sta("abs", 0x2006)
+    a.lda("imm", 0)
+    a.sta("abs", 0x2006)
+    a.ldy("imm", 0x10)
+    a.label("ny")
+    a.ldx("imm", 0)
+    a.label("nx")
+    rng(a)
+    a.sta("abs", 0x2007)
+    a.dex()
+    a.bne("rel", "nx")
+    a.dey()
+    a.bne("rel", "ny")
+
+    # palette
+    a.lda("imm", 0x3F)
+    a.sta("abs", 0x2006)
+    a.lda("imm", 0)
+    a.sta("abs", 0x2006)
+    a.ldx("imm", 32)
+    a.label("pl")
+    rng(a)
+    a.byte(0x29, 0x3F)  # and #$3F
+    a.sta("abs", 0x2007)
+    a.dex()
+    a.bne("rel", "pl")
+
+    # shadow OAM at $0200, sprite 0 at y = $40
+    a.ldx("imm", 0)
+    a.label("ol")
+    rng(a)
+    a.sta("abx", 0x0200)
+    a.inx()
+    a.bne("rel", "ol")
+    a.lda("imm", 0x40)
+    a.sta("abs", 0x0200)
+    a.lda("imm", 0x80)
+    a.sta("zp", CTRL)
+    a.lda("imm", 0x1E)
+    a.sta("zp", MASK)
+
+    # APU: pulses, triangle and noise on, frame counter IRQ enabled
+    for addr, value in [(0x4015, 0x0F), (0x4000, 0xBF), (0x4002, 0x60), (0x4003, 0x01), (0x4004, 0x9A), (0x4006, 0xC8),
+                        (0x4007, 0x00), (0x4008, 0xFF), (0x400A, 0x40), (0x400B, 0x02), (0x400C, 0x3C), (0x400E, 0x05),
+                        (0x400F, 0x08), (0x4017, 0x00)]:
+        a.lda("imm", value)
+        a.sta("abs", addr)
+
+    # MMC3 IRQ after 20 scanlines
+    a.lda("imm", 20)
+    a.sta("abs", 0xC000)
+    a.sta("abs", 0xC001)
+    a.sta("abs", 0xE001)
+
+    a.lda("zp", CTRL)
+    a.sta("abs", 0x2000)
+    a.lda("zp", MASK)
+    a.sta("abs", 0x2001)
+    a.cli()
+
+    # main loop: a random delay, then a random action
+    a.label("main")
+    rng(a)
+    a.byte(0x29, 0x0F)  # and #$0F
+    a.tax()
+    a.label("dl")
+    a.ldy("imm", 0x10)
+    a.label("dl2")
+    a.dey()
+    a.bne("rel", "dl2")
+    a.dex()
+    a.bpl("rel", "dl")
+    rng(a)
+    a.byte(0x29, 0x07)  # and #$07
+    a.asl("acc")
+    a.tax()
+    a.lda("abx", "jt")
+    a.sta("zp", PTR)
+    a.lda("abx", "jt1")
+    a.sta("zp", PTR + 1)
+    a.jmp("ind", PTR)
+
+    actions = []
+
+    def action(name):
+        a.label(name)
+        actions.append(name)
+
+    action("scroll")
+    rng(a)
+    a.sta("abs", 0x2005)
+    rng(a)
+    a.sta("abs", 0x2005)
+    a.jmp("abs", "main")
+
+    action("mask")
+    rng(a)
+    a.byte(0x09, 0x08)  # ora #$08
+    a.sta("abs", 0x2001)
+    a.jmp("abs", "main")
+
+    action("read")
+    a.lda("abs", 0x2002)
+    a.lda("abs", 0x2004)
+    a.sta("zp", TMP)
+    a.jmp("abs", "main")
+
+    action("sprite0")
+    a.ldx("imm", 0xFF)
+    a.label("s0")
+    a.bit("abs", 0x2002)
+    a.bvs("rel", "s0d")
+    a.dex()
+    a.bne("rel", "s0")
+    a.label("s0d")
+    rng(a)
+    a.sta("abs", 0x2005)
+    a.lda("zp", SCRY)
+    a.sta("abs", 0x2005)
+    a.jmp("abs", "main")
+
+    action("oam")
+    rng(a)
+    a.sta("abs", 0x2003)
+    rng(a)
+    a.sta("abs", 0x2004)
+    a.jmp("abs", "main")
+
+    action("banks")
+    rng(a)
+    a.byte(0x29, 0x07)  # and #$07
+    a.ora("imm", 0x00)
+    a.sta("abs", 0x8000)
+    rng(a)
+    a.byte(0x29, 0x3E)  # and #$3E
+    a.sta("abs", 0x8001)
+    a.lda("imm", 0x06)
+    a.sta("abs", 0x8000)
+    rng(a)
+    a.byte(0x29, 0x03)  # and #$03
+    a.sta("abs", 0x8001)
+    rng(a)
+    a.sta("abs", 0xA000)
+    a.jmp("abs", "main")
+
+    action("ctrl")
+    rng(a)
+    a.ora("imm", 0x80)
+    a.sta("abs", 0x2000)
+    a.sta("zp", CTRL)
+    rng(a)
+    a.sta("abs", 0x4002)
+    a.lda("abs", 0x4015)
+    a.jmp("abs", "main")
+
+    action("palette")
+    # interrupts would write PPUSCROLL between the PPUADDR writes, and rendering would move the address
+    a.sei()
+    a.lda("zp", CTRL)
+    a.byte(0x29, 0x7F)  # and #$7F
+    a.sta("abs", 0x2000)
+    a.lda("imm", 0)
+    a.sta("abs", 0x2001)
+    a.lda("abs", 0x2002)
+    a.lda("imm", 0x3F)
+    a.sta("abs", 0x2006)
+    rng(a)
+    a.byte(0x29, 0x1F)  # and #$1F
+    a.sta("abs", 0x2006)
+    rng(a)
+    a.sta("abs", 0x2007)
+    a.lda("zp", MASK)
+    a.sta("abs", 0x2001)
+    a.lda("zp", CTRL)
+    a.sta("abs", 0x2000)
+    a.cli()
+    a.jmp("abs", "main")
+
+    # jump table of the actions, filled once their addresses are known
+    a.label("jt")
+    table = len(a.code)
+    a.byte(*[0, 0] * len(actions))
+    a.labels["jt1"] = a.labels["jt"] + 1
+
+    a.label("nmi")
+    a.pha()
+    a.txa()
+    a.pha()
+    a.tya()
+    a.pha()
+    a.inc("zp", FRAME)
+    a.lda("imm", 0x00)
+    a.sta("abs", 0x2003)
+    a.lda("imm", 0x02)
+    a.sta("abs", 0x4014)
+    a.ldx("imm", 0)
+    a.label("ms")
+    a.inc("abx", 0x0203)
+    a.inx()
+    a.inx()
+    a.inx()
+    a.inx()
+    a.bne("rel", "ms")
+    a.lda("abs", 0x2002)
+    a.inc("zp", SCRX)
+    a.lda("zp", SCRX)
+    a.sta("abs", 0x2005)
+    a.lda("zp", FRAME)
+    a.byte(0x29, 0x7F)  # and #$7F
+    a.sta("zp", SCRY)
+    a.sta("abs", 0x2005)
+    a.lda("zp", FRAME)
+    a.byte(0x29, 0x01)  # and #$01
+    a.ora("zp", CTRL)
+    a.sta("abs", 0x2000)
+    a.lda("zp", FRAME)
+    a.sta("abs", 0x4006)
+    a.pla()
+    a.tay()
+    a.pla()
+    a.tax()
+    a.pla()
+    a.rti()
+
+    a.label("irq")
+    a.pha()
+    a.sta("abs", 0xE000)
+    a.lda("zp", FRAME)
+    a.sta("abs", 0x2005)
+    a.sta("abs", 0x2005)
+    a.lda("imm", 0x01)
+    a.sta("abs", 0x8000)
+    a.lda("zp", FRAME)
+    a.byte(0x29, 0x3E)  # and #$3E
+    a.sta("abs", 0x8001)
+    rng(a)
+    a.byte(0x29, 0x1F)  # and #$1F
+    a.ora("imm", 0x08)
+    a.sta("abs", 0xC000)
+    a.sta("abs", 0xC001)
+    a.sta("abs", 0xE001)
+    a.lda("abs", 0x4015)
+    a.pla()
+    a.rti()
+
+    code = a.resolve()
+    for i, name in enumerate(actions):
+        target = a.labels[name]
+        code[table + 2 * i] = target & 0xFF
+        code[table + 2 * i + 1] = target >> 8
+
+    return bytes(code), a.labels, a.org
+
+
+def rom(seed):
+    code, labels, org = build(seed)
+
+    # 64 KB of PRG ROM and 64 KB of CHR ROM filled with noise, the code is at the end of the last bank
+    rnd = random.Random(seed * 7 + 1)
+    prg = bytearray(rnd.randrange(256) for _ in range(4 * 16384))
+    base = len(prg) - (0x10000 - org)
+    prg[base:base + len(code)] = code
+    prg[-6:] = struct.pack("<HHH", labels["nmi"], labels["reset"], labels["irq"])
+    chr_rom = bytes(rnd.randrange(256) for _ in range(8 * 8192))
+
+    mapper = 4
+    header = b"NES\x1a" + bytes([4, 8, ((mapper & 0xF) << 4) | (seed % 2), mapper & 0xF0]) + bytes(8)
+    return header + bytes(prg) + chr_rom
+
+
+if __name__ == "__main__":
+    with open(sys.argv[1], "wb") as f:
+        f.write(rom(1))
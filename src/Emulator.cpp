@@ -13,6 +13,8 @@
 
 #include "Emulator.h"
 
+using namespace std::chrono_literals;
+
 namespace {
 std::string getFileSha256(std::string_view filePath) {
     std::ifstream ifs{filePath.data(), std::ifstream::binary | std::ifstream::in};
@@ -66,7 +68,6 @@ void Emulator::onBegin() {
     nes.insert(std::move(cartridge.value()));
 
     nes.getAPU().setSampleRate(SampleRate);
-    nes.getAPU().setSampleCallback(std::bind(&Emulator::sampleCallback, this, std::placeholders::_1));
     nes.powerUp();
 
     initKeyMap();
@@ -74,7 +75,8 @@ void Emulator::onBegin() {
     setFpsLimit(FPS);
     setVsyncEnabled(false);
 
-    audioMaker.setCallback(std::bind(&Emulator::audioMakerGetData, this));
+    audioMaker.setCallback(std::bind(&Emulator::audioMakerGetData, this, std::placeholders::_1));
+    audioMaker.setBufferSize(SampleCountPerFrame);
     audioMaker.setProcessingInterval(10);
     audioMaker.run();
 
@@ -82,15 +84,27 @@ void Emulator::onBegin() {
 }
 
 void Emulator::onUpdate() {
+    // The whole update is timed, drawing included, since that is what the frame budget has to cover.
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
     PixelEngine::onUpdate();
 
-    do {
-        nes.clock();
-    } while (!nes.getPPU().isFrameComplete());
+    bool skipped = skippedFrames < frameSkip;
+    nes.getPPU().setFrameSkipping(skipped);
 
-    renderFrame(nes.getPPU().getFrame());
+    nes.runFrame();
+    pushSamples();
+
+    if (skipped) {
+        skippedFrames++;
+    } else {
+        renderFrame(nes.getPPU().getFrame());
+        skippedFrames = 0;
+    }
 
     debug();
+
+    updateFrameSkip(std::chrono::steady_clock::now() - begin, skipped);
 }
 
 void Emulator::onEnd() {
@@ -98,12 +112,9 @@ void Emulator::onEnd() {
 
     saveGameAchieve();
 
-    {
-        std::lock_guard<std::mutex> lock{mtx};
-        stop = true;
-    }
-
-    cond.notify_one();
+    stop = true;
+    sampleFrames++;
+    sampleFrames.notify_one();
 }
 
 void Emulator::onKeyPress(PixelEngine::Key key) {
@@ -122,6 +133,15 @@ void Emulator::onKeyRelease(PixelEngine::Key key) {
     }
 }
 
+Emulator::AudioStats Emulator::audioStats() {
+    return AudioStats{
+        .queuedFrames = samples.size(),
+        .lowestFill = lowestFill.exchange(samples.capacity(), std::memory_order_relaxed),
+        .droppedSamples = droppedSamples.load(std::memory_order_relaxed),
+        .starvedWaits = audioStarved.load(std::memory_order_relaxed),
+    };
+}
+
 void Emulator::initKeyMap() {
     Joypad& joypad1 = nes.getJoypad1();
     Joypad& joypad2 = nes.getJoypad2();
@@ -249,50 +269,69 @@ void Emulator::renderFrame(const PPU::Frame& frame) {
     drawPixels(frame.getRawPixels());
 }
 
-void Emulator::resetAudioMaker() {
-    {
-        std::lock_guard<std::mutex> lock{mtx};
-        samples.clear();
-        stop = true;
+void Emulator::updateFrameSkip(std::chrono::steady_clock::duration updateTime, bool skipped) {
+    // moving averages, so that a single slow frame does not start skipping
+    std::chrono::steady_clock::duration& frameTime = skipped ? skippedFrameTime : drawnFrameTime;
+    frameTime += (updateTime - frameTime) / 16;
+
+    // Skip as few frames as possible while leaving 10% of the frame time as headroom.
+    const std::chrono::steady_clock::duration budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(1s) * 9 / 10 / FPS;
+
+    frameSkip = 0;
+    while (frameSkip != MaxFrameSkip && (drawnFrameTime + skippedFrameTime * frameSkip) / (frameSkip + 1) > budget) {
+        frameSkip++;
     }
-    cond.notify_one();
+}
+
+void Emulator::resetAudioMaker() {
+    stop = true;
+    sampleFrames++;
+    sampleFrames.notify_one();
 
     audioMaker.stop();
-    audioMaker.run();
 
-    {
-        std::lock_guard<std::mutex> lock{mtx};
-        stop = false;
-    }
+    // the audio thread is gone, so this thread may take the consumer side
+    samples.clear();
+    stop = false;
+
+    audioMaker.run();
 }
 
-void Emulator::sampleCallback(double sample) {
+void Emulator::pushSamples() {
+    std::array<std::int16_t, APU::SampleBufferSize> block;
+    const std::size_t count = nes.getAPU().readSamples(block);
+
 #ifdef OCFBNJ_NES_EMULATOR_DEBUG
-    sampleCount++;
+    sampleCount += count;
 #endif
 
-    auto value = static_cast<std::int16_t>(sample * 500);
-
-    {
-        std::unique_lock<std::mutex> lock{mtx};
+    // Samples that do not fit are dropped, the audio thread is behind anyway.
+    const std::size_t pushed = samples.push(std::span<const std::int16_t>{block.data(), count});
+    droppedSamples.store(droppedSamples.load(std::memory_order_relaxed) + count - pushed, std::memory_order_relaxed);
 
-        samples.emplace_back(value);
-        if (samples.size() >= SampleCountPerFrame) {
-            lock.unlock();
-            cond.notify_one();
-        }
-    }
+    sampleFrames++;
+    sampleFrames.notify_one();
 }
 
-std::vector<std::int16_t> Emulator::audioMakerGetData() {
-    std::vector<std::int16_t> data;
+std::size_t Emulator::audioMakerGetData(std::span<std::int16_t> data) {
+    std::size_t fill = samples.size();
 
-    {
-        std::unique_lock<std::mutex> lock{mtx};
-        cond.wait(lock, [this]() { return samples.size() >= SampleCountPerFrame || stop; });
+    while (fill < data.size() && !stop) {
+        // Read before checking the fill again, so that a frame pushed in between is not missed.
+        std::uint32_t frames = sampleFrames;
+
+        if ((fill = samples.size()) >= data.size() || stop) {
+            break;
+        }
+
+        audioStarved.store(audioStarved.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sampleFrames.wait(frames);
+        fill = samples.size();
+    }
 
-        samples.swap(data);
+    if (fill < lowestFill.load(std::memory_order_relaxed)) {
+        lowestFill.store(fill, std::memory_order_relaxed);
     }
 
-    return data;
+    return samples.pop(data);
 }
@@ -1,22 +1,31 @@
 #ifndef EMULATOR_H
 #define EMULATOR_H
 
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <functional>
-#include <mutex>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <unordered_map>
-#include <vector>
 
 #include <audio_maker/AudioMaker.h>
 #include <nes/Bus.h>
+#include <nes/SpscQueue.h>
 #include <pixel_engine/PixelEngine.h>
 
 class Emulator : public PixelEngine {
 public:
+    // Fill-level telemetry of the samples handed to the audio thread.
+    struct AudioStats {
+        std::size_t queuedFrames = 0;     // samples (mono frames) waiting in the queue
+        std::size_t lowestFill = 0;       // fewest samples the audio thread found queued since the last call
+        std::uint64_t droppedSamples = 0; // samples pushed to a full queue
+        std::uint64_t starvedWaits = 0;   // times the audio thread waited for samples
+    };
+
     explicit Emulator(std::string_view nesFile);
 
     void onBegin() override;
@@ -26,6 +35,8 @@ public:
     void onKeyPress(Key key) override;
     void onKeyRelease(Key key) override;
 
+    AudioStats audioStats();
+
 private:
     void initKeyMap();
 
@@ -38,10 +49,13 @@ private:
 
     void debug();
     void renderFrame(const PPU::Frame& frame);
+    // Picks how many frames to skip from the time taken by drawn and skipped frames.
+    void updateFrameSkip(std::chrono::steady_clock::duration updateTime, bool skipped);
     void resetAudioMaker();
 
-    void sampleCallback(double sample);
-    std::vector<std::int16_t> audioMakerGetData();
+    // Hands the samples of the frame just emulated to the audio thread.
+    void pushSamples();
+    std::size_t audioMakerGetData(std::span<std::int16_t> data);
 
     Bus nes;
     std::filesystem::path nesFilePath;
@@ -51,10 +65,23 @@ private:
     std::unordered_map<Key, std::function<void()>> releaseKeyMap;
 
     AudioMaker audioMaker;
-    std::vector<std::int16_t> samples;
-    std::condition_variable cond;
-    std::mutex mtx;
-    bool stop;
+    // Samples from the emulation thread to the audio thread, about 185 ms of them.
+    SpscQueue<std::int16_t, 8192> samples;
+    // Bumped every frame and when stopping, the audio thread waits on it.
+    std::atomic<std::uint32_t> sampleFrames = 0;
+    std::atomic<bool> stop;
+
+    // Fill-level telemetry, see audioStats().
+    std::atomic<std::uint64_t> droppedSamples = 0;
+    std::atomic<std::uint64_t> audioStarved = 0;
+    std::atomic<std::size_t> lowestFill = decltype(samples)::capacity();
+
+    // Under load, frames are skipped (emulated without being drawn) rather than slowing the game down.
+    static constexpr int MaxFrameSkip = 4;
+    int frameSkip = 0;     // frames skipped after each drawn frame
+    int skippedFrames = 0; // frames skipped since the last drawn frame
+    std::chrono::steady_clock::duration drawnFrameTime{};
+    std::chrono::steady_clock::duration skippedFrameTime{};
 
 #ifdef OCFBNJ_NES_EMULATOR_DEBUG
     std::uint16_t sampleCount = 0;
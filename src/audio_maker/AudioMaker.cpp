@@ -22,7 +22,8 @@ AudioMaker::AudioMaker(int sampleRate, int channelCount)
     : sampleRate(sampleRate),
       channelCount(channelCount),
       isStop(true),
-      processingInterval(10) {
+      processingInterval(10),
+      data(sampleRate / 60 * channelCount) {
     assert(channelCount == 1 || channelCount == 2);
     channelFormat = (channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
 
@@ -65,6 +66,11 @@ void AudioMaker::setProcessingInterval(int ms) {
     processingInterval = ms;
 }
 
+void AudioMaker::setBufferSize(std::size_t sampleCount) {
+    assert(isStop);
+    data.resize(sampleCount);
+}
+
 void AudioMaker::run() {
     alCheck(alGenSources(1, &source));
     alCheck(alSourcei(source, AL_BUFFER, 0));
@@ -144,14 +150,14 @@ void AudioMaker::closeQueue() {
 }
 
 void AudioMaker::fillAndPushBuffer(int bufferNum) {
-    std::vector<std::int16_t> data;
+    std::size_t count = 0;
 
     if (getData) {
-        data = getData();
+        count = getData(data);
     }
 
     ALuint buffer = buffers[bufferNum];
 
-    alCheck(alBufferData(buffer, channelFormat, data.data(), data.size() * sizeof(data[0]), sampleRate));
+    alCheck(alBufferData(buffer, channelFormat, data.data(), count * sizeof(data[0]), sampleRate));
     alCheck(alSourceQueueBuffers(source, 1, &buffer));
 }
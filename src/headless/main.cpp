@@ -0,0 +1,264 @@
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <nes/Bus.h>
+#include <nes/NesFile.h>
+
+// NesHeadless runs a ROM for a fixed number of frames as fast as possible,
+// without a window, an audio device or a frame limiter, and reports the emulation speed.
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr auto FrameWidth = 256;
+constexpr auto FrameHeight = 240;
+
+enum class Format {
+    Text,
+    Csv,
+    Json,
+};
+
+struct Options {
+    std::string nesFile;
+    long long frames = 600;
+    long long frameSkip = 0;
+    bool deferredRendering = false;
+    bool backgroundCanvas = false;
+    Format format = Format::Text;
+    std::string dumpFrame;
+    Bus::PpuSyncMode ppuSyncMode = Bus::PpuSyncMode::CatchUp;
+};
+
+struct Report {
+    std::string nesFile;
+    long long frames = 0;
+    double seconds = 0.0;
+    std::uint64_t frameHash = 0;
+};
+
+void printUsage(std::string_view program) {
+    std::cerr << "Usage: " << program << " <nes file> [options]\n"
+              << "Options:\n"
+              << "  --frames <n>           number of frames to run (default: 600)\n"
+              << "  --frame-skip <n>       frames skipped after each drawn frame, the last frame is drawn (default: 0)\n"
+              << "  --deferred-rendering   draw the scanlines on worker threads\n"
+              << "  --background-canvas    read the background from a canvas of the name tables\n"
+              << "  --format <fmt>         report format: text, csv or json (default: text)\n"
+              << "  --dump-frame <file>    write the final frame to a binary PPM file\n"
+              << "  --ppu-sync <mode>      PPU synchronization: catchup, lockstep or threaded (default: catchup)\n";
+}
+
+std::optional<Options> parseOptions(int argc, char* argv[]) {
+    Options options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+
+        if (arg == "--frames" && i + 1 < argc) {
+            std::string_view frames = argv[++i];
+            auto [ptr, ec] = std::from_chars(frames.data(), frames.data() + frames.size(), options.frames);
+            if (ec != std::errc{} || ptr != frames.data() + frames.size() || options.frames <= 0) {
+                return {};
+            }
+        } else if (arg == "--frame-skip" && i + 1 < argc) {
+            std::string_view frameSkip = argv[++i];
+            auto [ptr, ec] = std::from_chars(frameSkip.data(), frameSkip.data() + frameSkip.size(), options.frameSkip);
+            if (ec != std::errc{} || ptr != frameSkip.data() + frameSkip.size() || options.frameSkip < 0) {
+                return {};
+            }
+        } else if (arg == "--deferred-rendering") {
+            options.deferredRendering = true;
+        } else if (arg == "--background-canvas") {
+            options.backgroundCanvas = true;
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string_view format = argv[++i];
+            if (format == "text") {
+                options.format = Format::Text;
+            } else if (format == "csv") {
+                options.format = Format::Csv;
+            } else if (format == "json") {
+                options.format = Format::Json;
+            } else {
+                return {};
+            }
+        } else if (arg == "--dump-frame" && i + 1 < argc) {
+            options.dumpFrame = argv[++i];
+        } else if (arg == "--ppu-sync" && i + 1 < argc) {
+            std::string_view mode = argv[++i];
+            if (mode == "catchup") {
+                options.ppuSyncMode = Bus::PpuSyncMode::CatchUp;
+            } else if (mode == "lockstep") {
+                options.ppuSyncMode = Bus::PpuSyncMode::Lockstep;
+            } else if (mode == "threaded") {
+                options.ppuSyncMode = Bus::PpuSyncMode::Threaded;
+            } else {
+                return {};
+            }
+        } else if (!arg.starts_with("--") && options.nesFile.empty()) {
+            options.nesFile = arg;
+        } else {
+            return {};
+        }
+    }
+
+    if (options.nesFile.empty()) {
+        return {};
+    }
+
+    return options;
+}
+
+std::optional<Cartridge> loadQuietly(std::string_view path) {
+    // loadNesFile() describes the ROM on stdout, which would corrupt CSV and JSON reports.
+    std::streambuf* buf = std::cout.rdbuf(nullptr);
+    std::optional<Cartridge> cartridge = loadNesFile(path);
+    std::cout.rdbuf(buf);
+    std::cout.clear();
+
+    return cartridge;
+}
+
+bool dumpFrame(const PPU::Frame& frame, const std::string& path) {
+    std::ofstream ofs{path, std::ios_base::binary | std::ios_base::out | std::ios_base::trunc};
+    if (!ofs) {
+        return false;
+    }
+
+    ofs << "P6\n"
+        << FrameWidth << " " << FrameHeight << "\n255\n";
+
+    for (int y = 0; y != FrameHeight; y++) {
+        for (int x = 0; x != FrameWidth; x++) {
+            PPU::Pixel pixel = frame.getPixel(x, y);
+            const char rgb[] = {static_cast<char>(pixel.r), static_cast<char>(pixel.g), static_cast<char>(pixel.b)};
+            ofs.write(rgb, sizeof rgb);
+        }
+    }
+
+    return static_cast<bool>(ofs);
+}
+
+std::string escapeCsv(std::string_view str) {
+    std::string res;
+
+    for (char c : str) {
+        if (c == '"') {
+            res += '"';
+        }
+        res += c;
+    }
+
+    return res;
+}
+
+std::string escapeJson(std::string_view str) {
+    std::string res;
+
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+        }
+        res += c;
+    }
+
+    return res;
+}
+
+std::string hex(std::uint64_t value) {
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << value;
+    return oss.str();
+}
+
+void printReport(const Report& report, Format format) {
+    double fps = report.frames / report.seconds;
+    double speed = fps / FPS;
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    switch (format) {
+    case Format::Text:
+        std::cout << "ROM:        " << report.nesFile << "\n"
+                  << "Frames:     " << report.frames << "\n"
+                  << "Seconds:    " << report.seconds << "\n"
+                  << "FPS:        " << fps << "\n"
+                  << "Speed:      " << speed << "x\n"
+                  << "Frame hash: " << hex(report.frameHash) << "\n";
+        break;
+    case Format::Csv:
+        std::cout << "rom,frames,seconds,fps,speed,frame_hash\n"
+                  << "\"" << escapeCsv(report.nesFile) << "\","
+                  << report.frames << ","
+                  << report.seconds << ","
+                  << fps << ","
+                  << speed << ","
+                  << hex(report.frameHash) << "\n";
+        break;
+    case Format::Json:
+        std::cout << "{"
+                  << "\"rom\": \"" << escapeJson(report.nesFile) << "\", "
+                  << "\"frames\": " << report.frames << ", "
+                  << "\"seconds\": " << report.seconds << ", "
+                  << "\"fps\": " << fps << ", "
+                  << "\"speed\": " << speed << ", "
+                  << "\"frame_hash\": \"" << hex(report.frameHash) << "\""
+                  << "}\n";
+        break;
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::optional<Options> options = parseOptions(argc, argv);
+    if (!options.has_value()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    std::optional<Cartridge> cartridge = loadQuietly(options->nesFile);
+    if (!cartridge.has_value()) {
+        std::cerr << "Cannot load the NES ROM\n";
+        return -1;
+    }
+
+    Bus nes;
+    nes.insert(std::move(cartridge.value()));
+    nes.powerUp();
+    nes.setPpuSyncMode(options->ppuSyncMode);
+    nes.getPPU().setDeferredRendering(options->deferredRendering);
+    nes.getPPU().setBackgroundCanvas(options->backgroundCanvas);
+
+    Clock::time_point begin = Clock::now();
+
+    for (long long i = 0; i != options->frames; i++) {
+        // counted from the last frame, so that it is drawn
+        nes.getPPU().setFrameSkipping((options->frames - 1 - i) % (options->frameSkip + 1) != 0);
+        nes.runFrame();
+    }
+
+    std::chrono::duration<double> elapsed = Clock::now() - begin;
+
+    const PPU::Frame& frame = nes.getPPU().getFrame();
+
+    Report report{
+        .nesFile = options->nesFile,
+        .frames = options->frames,
+        .seconds = elapsed.count(),
+        .frameHash = frame.hash(),
+    };
+
+    printReport(report, options->format);
+
+    if (!options->dumpFrame.empty() && !dumpFrame(frame, options->dumpFrame)) {
+        std::cerr << "Cannot write the frame to " << options->dumpFrame << "\n";
+        return -1;
+    }
+}
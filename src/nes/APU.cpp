@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
@@ -26,6 +27,9 @@ static const std::array<double, 203> TndTable = [] {
 
     return res;
 }();
+
+// The mixer output (0.0 to 1.0) in the blip buffer.
+constexpr double AmplitudeScale = 1 << 14;
 } // namespace
 
 void APU::connect(Bus* bus) {
@@ -33,39 +37,59 @@ void APU::connect(Bus* bus) {
     dmc.connect(bus);
 }
 
+APU::EventClock::EventClock(std::uint32_t rate, std::uint64_t cycle)
+    : rate(rate) {
+    assert(rate > 0 && rate < ApuFrequency);
+
+    // the first event k after `cycle`
+    const std::uint64_t k = cycle * rate / ApuFrequency + 1;
+    next = (k * ApuFrequency + rate - 1) / rate;
+    carried = (k * ApuFrequency + rate - 1) % rate;
+}
+
+void APU::EventClock::advance() {
+    // period:  3 3 3 3 3 3 3 3 3 3 (rate 1, 3 cycles)
+    // cycle:   0 1 2 3 4 5 6 7 8 9
+    // events:        o     o     o
+    next += ApuFrequency / rate;
+    carried += ApuFrequency % rate;
+
+    if (carried >= rate) {
+        carried -= rate;
+        next++;
+    }
+}
+
 void APU::clock() {
-    stepTimer();
-
-    // i:      0 1 2 3 4 5 6 7 8 9
-    //         - - - - - - - - - -
-    // period: 3 3 3 3 3 3 3 3 3 3
-    // A, B:   0 0 0 1 1 1 2 2 2 3
-    //          x x o x x o x x o
-
-    std::uint64_t a = i;
-    i++;
-    std::uint64_t b = i;
-
-    double frameCounterPeriod = static_cast<double>(ApuFrequency) / FrameCounterFrequency;
-    auto frameCounterA = static_cast<std::uint64_t>(a / frameCounterPeriod);
-    auto frameCounterB = static_cast<std::uint64_t>(b / frameCounterPeriod);
-    if (frameCounterA != frameCounterB) {
-        stepFrameCounter();
+    if (++cycle == eventCycle) {
+        update();
     }
+}
+
+void APU::run(std::uint64_t cycles) {
+    assert(cycle + cycles <= eventCycle);
 
-    double samplePeriod = static_cast<double>(ApuFrequency) / sampleRate;
-    auto sampleA = static_cast<std::uint64_t>(a / samplePeriod);
-    auto sampleB = static_cast<std::uint64_t>(b / samplePeriod);
-    if (sampleA != sampleB) {
-        sendSample();
+    cycle += cycles;
+
+    if (cycle == eventCycle) {
+        update();
     }
 }
 
+std::uint64_t APU::cyclesUntilEvent() const {
+    return eventCycle - cycle;
+}
+
 void APU::reset() {
     frameCounter = 0;
     frameCounterMode = 4;
     irqInhibit = false;
-    i = 0;
+    cycle = 0;
+    channelCycle = 0;
+    frameCounterClock = EventClock{FrameCounterFrequency, cycle};
+
+    scheduleEvent();
+    restartOutput();
 }
 
 std::uint8_t APU::apuRead(std::uint16_t addr) {
@@ -81,6 +105,9 @@ std::uint8_t APU::apuRead(std::uint16_t addr) {
 
 void APU::apuWrite(std::uint16_t addr, std::uint8_t data) {
     assert(addr >= 0x4000 && addr < 0x4009 || addr >= 0x400A && addr < 0x400D || addr >= 0x400E && addr < 0x4014 || addr == 0x4015 || addr == 0x4017);
+
+    sync();
+
     switch (addr) {
     case 0x4000:
         pulse1.writeControl(data);
@@ -145,6 +172,9 @@ void APU::apuWrite(std::uint16_t addr, std::uint8_t data) {
     default:
         break;
     }
+
+    updateOutput();
+    scheduleEvent();
 }
 
 void APU::setSampleRate(int rate) {
@@ -152,10 +182,45 @@ void APU::setSampleRate(int rate) {
 
     assert(sampleRate > 0);
     assert(ApuFrequency > sampleRate);
+
+    restartOutput();
 }
 
-void APU::setSampleCallback(SampleCallback callback) {
-    sampleCallback = std::move(callback);
+template <typename Sample, typename Convert>
+std::size_t APU::readSamples(std::span<Sample> samples, Convert convert) {
+    if (std::size_t buffered = blip.samplesAvailable(cycle); buffered > SampleBufferSize) {
+        blip.discard(buffered - SampleBufferSize);
+    }
+
+    std::array<std::int32_t, 256> amplitudes;
+    std::size_t count = 0;
+
+    while (count != samples.size()) {
+        std::size_t n = blip.read(cycle, std::span{amplitudes}.first(std::min(amplitudes.size(), samples.size() - count)));
+        if (n == 0) {
+            break;
+        }
+
+        for (std::size_t i = 0; i != n; i++) {
+            samples[count + i] = convert(amplitudes[i]);
+        }
+
+        count += n;
+    }
+
+    return count;
+}
+
+std::size_t APU::readSamples(std::span<std::int16_t> samples) {
+    return readSamples(samples, [](std::int32_t amplitude) { return static_cast<std::int16_t>(amplitude * (500 / AmplitudeScale)); });
+}
+
+std::size_t APU::readSamples(std::span<float> samples) {
+    return readSamples(samples, [](std::int32_t amplitude) { return static_cast<float>(amplitude / AmplitudeScale); });
+}
+
+std::size_t APU::bufferedSamples() const {
+    return std::min(blip.samplesAvailable(cycle), SampleBufferSize);
 }
 
 void APU::serialize(std::ostream& os) const {
@@ -170,6 +235,7 @@ void APU::deserialize(std::istream& is) {
     is.read(begin, end - begin);
 
     dmc.connect(bus);
+    restartOutput();
 }
 
 std::uint8_t APU::readStatus() const {
@@ -238,16 +304,45 @@ void APU::writeFrameCounter(std::uint8_t data) {
     }
 }
 
-void APU::stepTimer() {
-    pulse1.stepTimer();
-    pulse2.stepTimer();
-    triangle.stepTimer();
-    triangle.stepTimer();
-    noise.stepTimer();
+void APU::runChannels(std::uint32_t cycles) {
+    pulse1.run(cycles);
+    pulse2.run(cycles);
+    triangle.run(cycles);
+    noise.run(cycles);
+
+    if (status.dmcEnabled()) {
+        dmc.run(cycles);
+    }
+}
+
+void APU::sync() {
+    assert(cycle <= eventCycle);
+
+    runChannels(static_cast<std::uint32_t>(cycle - channelCycle));
+    channelCycle = cycle;
+}
+
+void APU::update() {
+    sync();
+
+    if (cycle == frameCounterClock.next) {
+        stepFrameCounter();
+        frameCounterClock.advance();
+    }
+
+    updateOutput();
+    scheduleEvent();
+}
+
+void APU::scheduleEvent() {
+    std::uint32_t cycles = std::min({pulse1.cyclesUntilChange(), pulse2.cyclesUntilChange(), triangle.cyclesUntilChange(), noise.cyclesUntilChange()});
 
     if (status.dmcEnabled()) {
-        dmc.stepTimer();
+        cycles = std::min(cycles, dmc.cyclesUntilChange());
     }
+
+    // the frame counter bounds it, silent channels are never waited for
+    eventCycle = std::min(frameCounterClock.next, cycle + cycles);
 }
 
 void APU::stepLengthCounter() {
@@ -294,7 +389,7 @@ void APU::stepFrameCounter() {
             stepEnvelopeAndLinearCounter();
             if (!irqInhibit) {
                 assert(bus != nullptr);
-                bus->getCPU().irq();
+                bus->irq();
             }
             break;
         default:
@@ -330,12 +425,20 @@ void APU::stepFrameCounter() {
     frameCounter = (frameCounter + 1) % frameCounterMode;
 }
 
-void APU::sendSample() {
-    if (sampleCallback) {
-        sampleCallback(getOutputSample());
+void APU::updateOutput() {
+    const auto amplitude = static_cast<std::int32_t>(std::lround(getOutputSample() * AmplitudeScale));
+
+    if (amplitude != outputAmplitude) {
+        blip.addDelta(cycle, amplitude - outputAmplitude);
+        outputAmplitude = amplitude;
     }
 }
 
+void APU::restartOutput() {
+    outputAmplitude = static_cast<std::int32_t>(std::lround(getOutputSample() * AmplitudeScale));
+    blip.reset(ApuFrequency, sampleRate, cycle, outputAmplitude);
+}
+
 double APU::getOutputSample() const {
     std::uint8_t pulse1Out = status.pulse1Enabled() ? pulse1.output() : 0;
     std::uint8_t pulse2Out = status.pulse2Enabled() ? pulse2.output() : 0;
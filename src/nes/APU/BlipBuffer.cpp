@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+#include <nes/APU/BlipBuffer.h>
+
+namespace {
+// A step at each phase, spread over the taps as a windowed sinc, low-passed a bit under the Nyquist frequency.
+// The taps are integers that add up to exactly 1 << KernelBits, so that the sum of the samples never drifts.
+const auto Kernel = [] {
+    constexpr int Phases = BlipBuffer::Phases;
+    constexpr int Taps = BlipBuffer::Taps;
+    constexpr double Cutoff = 0.9;
+
+    std::array<std::array<std::int32_t, Taps>, Phases> kernel{};
+
+    for (int phase = 0; phase != Phases; phase++) {
+        std::array<double, Taps> taps{};
+        double total = 0;
+
+        for (int tap = 0; tap != Taps; tap++) {
+            // distance to the step, centered between the two middle taps
+            const double x = tap - (Taps / 2 - 1) - static_cast<double>(phase) / Phases;
+            const double sinc = x == 0 ? 1 : std::sin(std::numbers::pi * Cutoff * x) / (std::numbers::pi * Cutoff * x);
+            const double w = std::numbers::pi * x / (Taps / 2);
+            const double blackman = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2 * w);
+
+            taps[tap] = sinc * blackman;
+            total += taps[tap];
+        }
+
+        std::int32_t sum = 0;
+        for (int tap = 0; tap != Taps; tap++) {
+            kernel[phase][tap] = static_cast<std::int32_t>(std::lround(taps[tap] / total * (1 << BlipBuffer::KernelBits)));
+            sum += kernel[phase][tap];
+        }
+
+        // the rounding error goes to the largest tap
+        auto largest = std::max_element(kernel[phase].begin(), kernel[phase].end());
+        *largest += (1 << BlipBuffer::KernelBits) - sum;
+    }
+
+    return kernel;
+}();
+} // namespace
+
+void BlipBuffer::reset(std::uint32_t clockRate, std::uint32_t sampleRate, std::uint64_t time, std::int32_t amplitude) {
+    assert(sampleRate > 0 && sampleRate < clockRate);
+
+    this->clockRate = clockRate;
+    this->sampleRate = sampleRate;
+
+    deltas.fill(0);
+    readIndex = position(time) / clockRate;
+    sum = amplitude * (1 << KernelBits);
+}
+
+void BlipBuffer::addDelta(std::uint64_t time, std::int32_t delta) {
+    const std::uint64_t pos = position(time);
+    const std::uint64_t index = pos / clockRate;
+    const int phase = static_cast<int>(pos % clockRate * Phases / clockRate);
+
+    assert(index >= readIndex);
+
+    // Samples nobody reads make room for the new ones.
+    if (index + Taps > readIndex + Capacity) {
+        discard(index + Taps - (readIndex + Capacity));
+    }
+
+    const std::array<std::int32_t, Taps>& taps = Kernel[phase];
+    for (int tap = 0; tap != Taps; tap++) {
+        deltas[(index + tap) % Capacity] += delta * taps[tap];
+    }
+}
+
+std::size_t BlipBuffer::samplesAvailable(std::uint64_t time) const {
+    // A change at `time` or later only alters the samples from this one on.
+    return position(time) / clockRate - readIndex;
+}
+
+std::size_t BlipBuffer::read(std::uint64_t time, std::span<std::int32_t> amplitudes) {
+    const std::size_t count = std::min(amplitudes.size(), samplesAvailable(time));
+
+    for (std::size_t i = 0; i != count; i++) {
+        std::int32_t& delta = deltas[(readIndex + i) % Capacity];
+        sum += delta;
+        delta = 0;
+
+        amplitudes[i] = sum >> KernelBits;
+    }
+
+    readIndex += count;
+
+    return count;
+}
+
+void BlipBuffer::discard(std::size_t count) {
+    // past a full ring, the deltas left are all 0
+    for (std::size_t i = 0; i != std::min(count, Capacity); i++) {
+        std::int32_t& delta = deltas[(readIndex + i) % Capacity];
+        sum += delta;
+        delta = 0;
+    }
+
+    readIndex += count;
+}
+
+std::uint64_t BlipBuffer::position(std::uint64_t time) const {
+    // in 1 / clockRate samples, exact for over 10 years of emulation
+    return time * sampleRate;
+}
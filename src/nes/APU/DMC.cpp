@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 
 #include <nes/APU/DMC.h>
@@ -15,6 +16,15 @@ std::uint8_t DMC::output() const {
     return value;
 }
 
+std::uint32_t DMC::cyclesUntilChange() const {
+    if (bitCount == 0) {
+        // the reader fetches the next byte right away, if there is one
+        return currentLength > 0 ? 1 : Timer::Never;
+    }
+
+    return timer.stepsUntilReload();
+}
+
 void DMC::connect(Bus* bus) {
     this->bus = bus;
 }
@@ -23,11 +33,17 @@ void DMC::resetCurrentLength() {
     currentLength = 0;
 }
 
-void DMC::stepTimer() {
-    stepReader();
+void DMC::run(std::uint32_t cycles) {
+    while (cycles != 0) {
+        stepReader();
+
+        // The reader has nothing to do again before the shifter empties, when the timer is reloaded.
+        std::uint32_t steps = std::min(cycles, timer.stepsUntilReload());
+        if (timer.run(steps) != 0) {
+            stepShifter();
+        }
 
-    if (timer.step()) {
-        stepShifter();
+        cycles -= steps;
     }
 }
 
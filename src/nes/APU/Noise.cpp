@@ -25,12 +25,20 @@ std::uint8_t Noise::output() const {
     return envelope.getVolume();
 }
 
+std::uint32_t Noise::cyclesUntilChange() const {
+    if (lengthCounter.isZero() || envelope.getVolume() == 0) {
+        return Timer::Never;
+    }
+
+    return timer.stepsUntilReload();
+}
+
 void Noise::resetLengthCounter() {
     lengthCounter.setCounter(0);
 }
 
-void Noise::stepTimer() {
-    if (timer.step()) {
+void Noise::run(std::uint32_t cycles) {
+    for (std::uint32_t reloads = timer.run(cycles); reloads != 0; reloads--) {
         // When the timer clocks the shift register, the following actions occur in order:
         // 1. Feedback is calculated as the exclusive-OR of bit 0 and one other bit: bit 6 if Mode flag is set, otherwise bit 1.
         // 2. The shift register is shifted right by one bit.
@@ -31,14 +31,20 @@ std::uint8_t Pulse::output() const {
     return envelope.getVolume();
 }
 
+std::uint32_t Pulse::cyclesUntilChange() const {
+    if (muting() || lengthCounter.isZero() || envelope.getVolume() == 0) {
+        return Timer::Never;
+    }
+
+    return timer.stepsUntilReload();
+}
+
 void Pulse::resetLengthCounter() {
     lengthCounter.setCounter(0);
 }
 
-void Pulse::stepTimer() {
-    if (timer.step()) {
-        dutyValue = (dutyValue + 1) % 8;
-    }
+void Pulse::run(std::uint32_t cycles) {
+    dutyValue = (dutyValue + timer.run(cycles)) % 8;
 }
 
 void Pulse::stepLengthCounter() {
@@ -1,12 +1,21 @@
 #include <nes/APU/Timer.h>
 
-bool Timer::step() {
-    if (counter == 0) {
-        counter = period;
-        return true;
-    } else if (counter > 0) {
-        counter--;
+std::uint32_t Timer::run(std::uint32_t steps) {
+    // Each step reloads a counter at 0, and decrements it otherwise.
+    if (steps <= counter) {
+        counter -= steps;
+        return 0;
     }
 
-    return false;
+    steps -= counter + 1;
+
+    // reloaded once, then every period + 1 steps
+    const std::uint32_t reloads = 1 + steps / (period + 1);
+    counter = period - steps % (period + 1);
+
+    return reloads;
+}
+
+std::uint32_t Timer::stepsUntilReload() const {
+    return counter + 1;
 }
@@ -22,15 +22,24 @@ std::uint8_t Triangle::output() const {
     return TriangleTable[dutyValue];
 }
 
+std::uint32_t Triangle::cyclesUntilChange() const {
+    if (halted()) {
+        return Timer::Never;
+    }
+
+    // the timer is clocked twice per APU cycle
+    return (timer.stepsUntilReload() + 1) / 2;
+}
+
 void Triangle::resetLengthCounter() {
     lengthCounter.setCounter(0);
 }
 
-void Triangle::stepTimer() {
-    if (timer.step()) {
-        if (linearCounterValue > 0 && lengthCounter.greaterZero()) {
-            dutyValue = (dutyValue + 1) % 32;
-        }
+void Triangle::run(std::uint32_t cycles) {
+    std::uint32_t reloads = timer.run(cycles * 2);
+
+    if (!halted()) {
+        dutyValue = (dutyValue + reloads) % 32;
     }
 }
 
@@ -67,3 +76,8 @@ void Triangle::writeTimerHi(std::uint8_t data) {
 
     reload = true;
 }
+
+bool Triangle::halted() const {
+    // The sequencer only moves while both counters are nonzero.
+    return linearCounterValue == 0 || lengthCounter.isZero();
+}
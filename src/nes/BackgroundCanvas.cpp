@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cassert>
+
+#include <nes/BackgroundCanvas.h>
+#include <nes/Bus.h>
+
+void BackgroundCanvas::read(Bus& bus, std::uint16_t patternAddr, int row, int column, int tiles, std::uint8_t* pixels) {
+    assert(row >= 0 && row < Rows);
+    assert(column >= 0 && column < Columns);
+    assert(tiles >= 0 && tiles <= Columns);
+
+    if (patternAddr != this->patternAddr) {
+        this->patternAddr = patternAddr;
+        invalidateAll();
+    }
+
+    for (int tile = 0; tile != tiles; tile++) {
+        int col = (column + tile) % Columns;
+
+        if (drawn[row * Columns + col] != generation) {
+            drawTileRow(bus, row, col);
+        }
+
+        std::copy_n(this->pixels.data() + (row * Columns + col) * 8, 8, pixels + tile * 8);
+    }
+}
+
+void BackgroundCanvas::invalidate(std::uint16_t addr) {
+    assert(addr >= 0x2000 && addr < 0x3000);
+
+    const std::uint16_t offset = addr & 0x03FF;
+
+    auto invalidateTile = [this](int table, int coarseX, int coarseY) {
+        const int column = (table % 2) * 32 + coarseX;
+        const int top = (table / 2) * 240 + coarseY * 8;
+
+        for (int row = top; row != top + 8; row++) {
+            drawn[row * Columns + column] = 0;
+        }
+    };
+
+    // The canvas does not know the mirroring, the same tiles are outdated in all four name tables.
+    for (int table = 0; table != 4; table++) {
+        if (offset < 0x03C0) {
+            invalidateTile(table, offset % 32, offset / 32);
+        } else {
+            // each attribute byte covers 4x4 tiles, the last row of them is only half on the name table
+            const int left = (offset - 0x03C0) % 8 * 4;
+            const int top = (offset - 0x03C0) / 8 * 4;
+
+            for (int coarseY = top; coarseY != top + 4 && coarseY < 30; coarseY++) {
+                for (int coarseX = left; coarseX != left + 4; coarseX++) {
+                    invalidateTile(table, coarseX, coarseY);
+                }
+            }
+        }
+    }
+}
+
+void BackgroundCanvas::invalidateAll() {
+    if (++generation == 0) {
+        drawn.fill(0);
+        generation = 1;
+    }
+}
+
+void BackgroundCanvas::drawTileRow(Bus& bus, int row, int column) {
+    // the name table of the tile, and where the tile is in it
+    const std::uint16_t table = 0x2000 + ((row / 240) * 2 + column / 32) * 0x0400;
+    const int coarseX = column % 32;
+    const int coarseY = row % 240 / 8;
+    const int fineY = row % 8;
+
+    // same fetches as PPU::fetchTile()
+    std::uint8_t ntByte = bus.ppuRead(table + coarseY * 32 + coarseX);
+    std::uint8_t atByte = bus.ppuRead(table + 0x03C0 + coarseY / 4 * 8 + coarseX / 4);
+
+    if (coarseY & 0x02) {
+        atByte >>= 4;
+    }
+    if (coarseX & 0x02) {
+        atByte >>= 2;
+    }
+
+    atByte &= 0x03;
+
+    const TileCache::Row& tileRow = bus.ppuTileRow(patternAddr + (ntByte << 4) + fineY);
+
+    std::uint8_t* dst = pixels.data() + (row * Columns + column) * 8;
+    for (int x = 0; x != 8; x++) {
+        dst[x] = (atByte << 2) | tileRow[x];
+    }
+
+    drawn[row * Columns + column] = generation;
+}
@@ -1,8 +1,13 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <limits>
+#include <thread>
 #include <utility>
 
 #include <nes/Bus.h>
 #include <nes/Mirroring.h>
+#include <nes/SpscQueue.h>
 
 namespace {
 std::uint16_t mirrorPaletteAddr(std::uint16_t addr) {
@@ -16,45 +21,22 @@ std::uint16_t mirrorPaletteAddr(std::uint16_t addr) {
     assert(addr >= 0x3F00 && addr < 0x3F20);
     return addr;
 }
+} // namespace
 
-std::uint16_t mirrorVramAddr(std::uint16_t addr, Mirroring mirroring) {
-    assert(addr >= 0x2000 && addr < 0x3F00);
-
-    const std::uint16_t vramIndex = addr - 0x2000;
-    assert(vramIndex >= 0 && vramIndex < 0x1000);
+// What the CPU thread and the PPU thread share in Threaded mode.
+struct Bus::PpuThread {
+    SpscQueue<PpuEvent, 1024> events;
+    std::atomic<std::uint64_t> pushed = 0;  // events pushed by the CPU thread
+    std::atomic<std::uint64_t> handled = 0; // events handled by the PPU thread
+    std::atomic<std::uint64_t> cycle = 0;   // ppuDeadline as of the last event handled
+    std::thread thread;
+};
 
-    const std::uint8_t nameTable = vramIndex / 0x0400;
-    assert(nameTable >= 0 && nameTable < 4);
+Bus::Bus() = default;
 
-    switch (mirroring) {
-    case Mirroring::OneScreenLoBank:
-        addr = addr & 0x23FF;
-        break;
-    case Mirroring::OneScreenUpBank:
-        addr = 0x2400 + (addr & 0x03FF);
-        break;
-    case Mirroring::Vertical:
-        if (nameTable == 0 || nameTable == 2) {
-            addr = addr & 0x23FF;
-        } else if (nameTable == 1 || nameTable == 3) {
-            addr = 0x2400 + (addr & 0x03FF);
-        }
-        break;
-    case Mirroring::Horizontal:
-        if (nameTable == 0 || nameTable == 1) {
-            addr = addr & 0x23FF;
-        } else if (nameTable == 2 || nameTable == 3) {
-            addr = 0x2400 + (addr & 0x03FF);
-        }
-        break;
-    default:
-        assert(0);
-    }
-
-    assert(addr >= 0x2000 && addr < 0x2800);
-    return addr;
+Bus::~Bus() {
+    stopPpuThread();
 }
-} // namespace
 
 void Bus::insert(Cartridge cartridge) {
     mapper = Mapper::create(std::move(cartridge));
@@ -68,6 +50,21 @@ void Bus::powerUp() {
     ppu.connect(this);
     apu.connect(this);
 
+    // CPU RAM is mirrored every 2 KB up to $1FFF
+    cpuPages = PageTable{};
+    for (std::uint16_t addr = 0x0000; addr != 0x2000; addr += 2_kb) {
+        cpuPages.mapRead(addr, 2_kb, cpuRam.data());
+        cpuPages.mapWrite(addr, 2_kb, cpuRam.data());
+    }
+
+    mapper->connect(&cpuPages);
+
+    chr = mapper->chr();
+    tileCache.reset(chr);
+    ppuMemoryCopy.reset();
+    ppuMemoryChanged = true;
+    chrChanged = true;
+
     reset();
 }
 
@@ -78,18 +75,44 @@ void Bus::serialize(std::ostream& os) const {
     ppu.serialize(os);
     os.write(reinterpret_cast<const char*>(cpuRam.data()), cpuRam.size());
     os.write(reinterpret_cast<const char*>(ppuRam.data()), ppuRam.size());
+
+    os.write(reinterpret_cast<const char*>(&masterCycle), sizeof masterCycle);
+    os.write(reinterpret_cast<const char*>(&ppuDeadline), sizeof ppuDeadline);
+    os.write(reinterpret_cast<const char*>(&cpuDeadline), sizeof cpuDeadline);
+    os.write(reinterpret_cast<const char*>(&apuDeadline), sizeof apuDeadline);
 }
 
 void Bus::deserialize(std::istream& is) {
     mapper->deserialize(is);
+    mapper->mapPrgPages();
+    mapNameTables();
+    mapChrPages();
+    tileCache.reset(chr); // CHR RAM is restored
     cpu.deserialize(is);
     apu.deserialize(is);
     ppu.deserialize(is);
     is.read(reinterpret_cast<char*>(cpuRam.data()), cpuRam.size());
     is.read(reinterpret_cast<char*>(ppuRam.data()), ppuRam.size());
+    ppuMemoryChanged = true;
+    chrChanged = true;
+    ppu.invalidateBackground();
+
+    is.read(reinterpret_cast<char*>(&masterCycle), sizeof masterCycle);
+    is.read(reinterpret_cast<char*>(&ppuDeadline), sizeof ppuDeadline);
+    is.read(reinterpret_cast<char*>(&cpuDeadline), sizeof cpuDeadline);
+    is.read(reinterpret_cast<char*>(&apuDeadline), sizeof apuDeadline);
+
+    mapperIrqPending = mapper->irqState();
+    ppuRequested = ppuDeadline;
+    updatePpuEventDeadline();
+    updateApuEventDeadline();
 }
 
 std::uint8_t Bus::cpuRead(std::uint16_t addr) {
+    if (const std::uint8_t* page = cpuPages.read[addr / PageTable::PageSize]) {
+        return page[addr % PageTable::PageSize];
+    }
+
     std::uint8_t data = 0;
 
     if (addr >= 0x0000 && addr < 0x2000) {
@@ -98,6 +121,8 @@ std::uint8_t Bus::cpuRead(std::uint16_t addr) {
     } else if (addr >= 0x2000 && addr < 0x4000) {
         addr &= 0x2007;
 
+        syncPpu(masterCycle);
+
         // The PPU exposes eight memory-mapped registers to the CPU.
         if (addr == 0x2002) {
             // PPU Status Register
@@ -115,6 +140,7 @@ std::uint8_t Bus::cpuRead(std::uint16_t addr) {
     } else if (addr >= 0x4000 && addr < 0x4018) {
         if (addr == 0x4015) {
             // APU Status Register
+            syncApu(masterCycle);
             data = apu.apuRead(addr);
         } else if (addr == 0x4016) {
             data = joypad1.read();
@@ -142,42 +168,38 @@ std::uint16_t Bus::cpuRead16(std::uint16_t addr) {
 }
 
 void Bus::cpuWrite(std::uint16_t addr, std::uint8_t data) {
+    if (std::uint8_t* page = cpuPages.write[addr / PageTable::PageSize]) {
+        page[addr % PageTable::PageSize] = data;
+
+        if (addr < 0x2000) {
+            cpu.invalidateRamCode(addr);
+        }
+        return;
+    }
+
     if (addr >= 0x0000 && addr < 0x2000) {
         // CPU RAM
         cpuRam[addr & 0x07FF] = data;
+        cpu.invalidateRamCode(addr);
     } else if (addr >= 0x2000 && addr < 0x4000) {
         addr &= 0x2007;
 
-        // The PPU exposes eight memory-mapped registers to the CPU.
-        if (addr == 0x2000) {
-            // PPU Controller Register
-            ppu.writeCtrl(data);
-        } else if (addr == 0x2001) {
-            // PPU Mask Register
-            ppu.writeMask(data);
-        } else if (addr == 0x2003) {
-            // PPU OAM Address Register
-            ppu.writeOamAddr(data);
-        } else if (addr == 0x2004) {
-            // PPU OAM Data Register
-            ppu.writeOamData(data);
-        } else if (addr == 0x2005) {
-            // PPU Scroll Data Register
-            ppu.writeScroll(data);
-        } else if (addr == 0x2006) {
-            // PPU Address Register
-            ppu.writeAddr(data);
-        } else if (addr == 0x2007) {
-            // PPU Data Register
-            ppu.writeData(data);
+        if (ppuThread != nullptr && addr >= 0x2003) {
+            // These writes only change the PPU itself, the PPU thread makes them when it gets there.
+            pushPpuEvent({.kind = PpuEvent::Kind::Write, .addr = addr, .data = data, .cycle = masterCycle});
         } else {
-            // PPU Status Register is read-only. (some games do write these registers?)
-            // assert(0);
+            syncPpu(masterCycle);
+            writePpuRegister(addr, data);
+
+            // Writes to PPUMASK change whether the mapper scanline counter is clocked.
+            updatePpuEventDeadline();
         }
     } else if (addr >= 0x4000 && addr < 0x4018) {
         if (addr >= 0x4000 && addr < 0x4009 || addr >= 0x400A && addr < 0x400D || addr >= 0x400E && addr < 0x4014 || addr == 0x4015 || addr == 0x4017) {
             // APU addresses
+            syncApu(masterCycle);
             apu.apuWrite(addr, data);
+            updateApuEventDeadline();
         } else if (addr == 0x4014) {
             // Writing $XX will upload 256 bytes of data from CPU page $XX00-$XXFF to the internal PPU OAM.
             std::array<std::uint8_t, 256> buffer{};
@@ -186,6 +208,7 @@ void Bus::cpuWrite(std::uint16_t addr, std::uint8_t data) {
                 buffer[i] = cpuRead(hi | i);
             }
 
+            syncPpu(masterCycle);
             ppu.writeOamDMA(buffer);
         } else if (addr == 0x4016) {
             joypad1.write(data);
@@ -196,8 +219,18 @@ void Bus::cpuWrite(std::uint16_t addr, std::uint8_t data) {
         // See https://wiki.nesdev.org/w/index.php?title=CPU_Test_Mode
         assert(0);
     } else {
+        // Mapper registers may switch CHR banks or change the mirroring, which the PPU observes.
+        if (addr >= 0x8000) {
+            syncPpu(masterCycle);
+        }
+
         // Save RAM and PRG ROM that stored in cartridge.
         mapper->cpuWrite(addr, data);
+
+        if (addr >= 0x8000) {
+            mapNameTables();
+            mapChrPages();
+        }
     }
 }
 
@@ -206,12 +239,12 @@ std::uint8_t Bus::ppuRead(std::uint16_t addr) {
 
     if (addr >= 0x0000 && addr < 0x2000) {
         // CHR ROM (aka pattern table)
-        data = mapper->ppuRead(addr);
+        data = chr[chrPages[addr >> 10] + (addr & 0x03FF)];
     } else if (addr >= 0x2000 && addr < 0x3F00) {
         addr &= 0x2FFF;
 
         // PPU RAM (aka name table)
-        data = ppuRam[mirrorVramAddr(addr, mapper->mirroring()) - 0x2000];
+        data = nameTables[(addr >> 10) & 0x03][addr & 0x03FF];
     } else if (addr >= 0x3F00 && addr < 0x4000) {
         addr &= 0x3F1F;
 
@@ -228,11 +261,15 @@ void Bus::ppuWrite(std::uint16_t addr, std::uint8_t data) {
     if (addr >= 0x0000 && addr < 0x2000) {
         // CHR ROM (aka pattern table)
         mapper->ppuWrite(addr, data);
+        tileCache.invalidate(chrPages[addr >> 10] + (addr & 0x03FF));
+        ppuMemoryChanged = true;
+        chrChanged = true;
     } else if (addr >= 0x2000 && addr < 0x3F00) {
         addr &= 0x2FFF;
 
         // PPU RAM (aka name table)
-        ppuRam[mirrorVramAddr(addr, mapper->mirroring()) - 0x2000] = data;
+        nameTables[(addr >> 10) & 0x03][addr & 0x03FF] = data;
+        ppuMemoryChanged = true;
     } else if (addr >= 0x3F00 && addr < 0x4000) {
         addr &= 0x3F1F;
 
@@ -243,34 +280,447 @@ void Bus::ppuWrite(std::uint16_t addr, std::uint8_t data) {
     }
 }
 
+const TileCache::Row& Bus::ppuTileRow(std::uint16_t addr) {
+    assert(addr < 0x2000 && (addr & 0x08) == 0);
+    return tileCache.row(chr, chrPages[addr >> 10] + (addr & 0x03FF));
+}
+
+std::shared_ptr<const PPU::VideoMemory> Bus::ppuMemory() {
+    if (!ppuMemoryChanged) {
+        return ppuMemoryCopy;
+    }
+
+    auto memory = std::make_shared<PPU::VideoMemory>();
+
+    for (int i = 0; i != 4; i++) {
+        std::copy_n(nameTables[i], 1_kb, memory->nameTables.data() + i * 1_kb);
+    }
+
+    memory->chrPages = chrPages;
+
+    // CHR ROM is copied once, CHR RAM again after it is written
+    if (chrChanged || ppuMemoryCopy == nullptr) {
+        memory->chr = std::make_shared<const std::vector<std::uint8_t>>(chr.begin(), chr.end());
+    } else {
+        memory->chr = ppuMemoryCopy->chr;
+    }
+
+    ppuMemoryCopy = std::move(memory);
+    ppuMemoryChanged = false;
+    chrChanged = false;
+
+    return ppuMemoryCopy;
+}
+
+void Bus::mapNameTables() {
+    // physical 1 KB table of each logical name table
+    // See https://www.nesdev.org/wiki/Mirroring#Nametable_Mirroring
+    std::array<std::uint8_t, 4> tables{};
+
+    switch (mapper->mirroring()) {
+    case Mirroring::OneScreenLoBank:
+        tables = {0, 0, 0, 0};
+        break;
+    case Mirroring::OneScreenUpBank:
+        tables = {1, 1, 1, 1};
+        break;
+    case Mirroring::Vertical:
+        tables = {0, 1, 0, 1};
+        break;
+    case Mirroring::Horizontal:
+        tables = {0, 0, 1, 1};
+        break;
+    case Mirroring::FourScreen:
+        tables = {0, 1, 2, 3};
+        break;
+    default:
+        assert(0);
+    }
+
+    for (int i = 0; i != 4; i++) {
+        if (nameTables[i] != ppuRam.data() + tables[i] * 1_kb) {
+            nameTables[i] = ppuRam.data() + tables[i] * 1_kb;
+            ppuMemoryChanged = true;
+            ppu.invalidateBackground();
+        }
+    }
+}
+
+void Bus::mapChrPages() {
+    for (std::uint16_t page = 0; page != chrPages.size(); page++) {
+        std::uint32_t offset = mapper->chrOffset(page * 1_kb) % chr.size();
+
+        if (chrPages[page] != offset) {
+            chrPages[page] = offset;
+            ppuMemoryChanged = true;
+            ppu.invalidateBackground();
+        }
+    }
+}
+
+void Bus::nmi() {
+    nmiCount++;
+
+    // The PPU is clocked before the CPU, so the CPU takes the NMI on this cycle.
+    if (cpu.nmi()) {
+        runCpuFrom(masterCycle);
+    }
+}
+
+void Bus::irq() {
+    irqCount++;
+
+    // The APU and the mapper are clocked after the CPU, so the CPU takes the IRQ on its next cycle.
+    if (cpu.irq()) {
+        runCpuFrom(masterCycle + 1);
+    }
+}
+
+void Bus::runCpuFrom(std::uint64_t cycle) {
+    // The CPU drops what is left of the running instruction, as it does when clocked cycle by cycle.
+    cpuDeadline = std::min(cpuDeadline, cycle + (cpuDeadline - cycle) % CpuClockDivider);
+}
+
+void Bus::mapperScanline() {
+    mapper->scanline();
+
+    // The mapper only raises its IRQ line when its scanline counter is clocked,
+    // so there is no need to poll it on every cycle.
+    if (mapper->irqState()) {
+        mapperIrqPending = true;
+    }
+}
+
 void Bus::clock() {
-    static std::uint8_t i = 0;
+    tick<false>();
 
-    ppu.clock();
+    // The PPU is clocked right here, even in Threaded mode.
+    ppuRequested = ppuDeadline;
+}
 
-    if ((i % 3) == 0) {
-        cpu.clock();
+template <bool CatchUp>
+void Bus::tick() {
+    if constexpr (CatchUp) {
+        if (masterCycle >= ppuEventDeadline) {
+            syncPpu(masterCycle);
+        } else if (ppuThread != nullptr && masterCycle >= ppuRequested + PpuThreadStep) {
+            // keeps the PPU thread busy while the CPU runs
+            pushPpuEvent({.kind = PpuEvent::Kind::Run, .cycle = masterCycle});
+        }
+    } else {
+        ppu.clock();
+        ppuDeadline += PpuClockDivider;
+
+        if (ppu.isFrameComplete()) {
+            ppuFrameComplete = true;
+        }
     }
 
-    if ((i % 6) == 0) {
+    if (masterCycle == cpuDeadline) {
+        if constexpr (CatchUp) {
+            cpuDeadline += cpu.stepInstruction() * CpuClockDivider;
+        } else {
+            cpu.clock();
+            cpuDeadline += CpuClockDivider;
+        }
+    }
+
+    if constexpr (CatchUp) {
+        if (masterCycle >= apuEventDeadline) {
+            syncApu(masterCycle + 1);
+        }
+    } else if (masterCycle == apuDeadline) {
         apu.clock();
+        apuDeadline += ApuClockDivider;
     }
 
-    if (mapper->irqState()) {
-        mapper->irqClear();
-        cpu.irq();
+    if (mapperIrqPending) {
+        mapperIrqPending = false;
+
+        // The CPU may have acknowledged the IRQ in the meantime.
+        if (mapper->irqState()) {
+            mapper->irqClear();
+            irq();
+        }
     }
 
-    if (++i == 6) {
-        i = 0;
+    if constexpr (CatchUp) {
+        // Nothing happens until the next deadline.
+        masterCycle = std::min({cpuDeadline, apuEventDeadline, ppuEventDeadline});
+    } else {
+        masterCycle++;
     }
 }
 
+void Bus::syncPpu(std::uint64_t cycle) {
+    if (ppuThread != nullptr) {
+        // the same early return as below, from what the PPU thread has been asked to run
+        const bool behind = ppuRequested <= cycle;
+        if (behind) {
+            pushPpuEvent({.kind = PpuEvent::Kind::Run, .cycle = cycle});
+        }
+
+        waitPpu();
+
+        if (!behind) {
+            return;
+        }
+    } else {
+        if (ppuDeadline > cycle) {
+            return;
+        }
+
+        runPpu(cycle);
+    }
+
+    // The end of a frame is always a PPU event,
+    // so it can only be the last cycle of a synchronization.
+    if (ppu.isFrameComplete()) {
+        ppuFrameComplete = true;
+    }
+
+    updatePpuEventDeadline();
+}
+
+void Bus::updatePpuEventDeadline() {
+    ppuEventDeadline = ppuDeadline + ppu.cyclesUntilEvent(mapper->countsScanlines()) * PpuClockDivider;
+}
+
+void Bus::runPpu(std::uint64_t cycle) {
+    if (ppuDeadline > cycle) {
+        return;
+    }
+
+    // Nothing can touch the PPU until the synchronization ends,
+    // so it can run whole scanlines and stretches of idle cycles in a single step.
+    // A synchronization never goes past the next PPU event, which is less than a frame away.
+    const std::uint64_t cycles = (cycle - ppuDeadline) / PpuClockDivider + 1;
+    assert(cycles <= std::numeric_limits<int>::max());
+
+    ppu.run(static_cast<int>(cycles));
+    ppuDeadline += cycles * PpuClockDivider;
+}
+
+void Bus::syncApu(std::uint64_t cycle) {
+    if (apuDeadline >= cycle) {
+        return;
+    }
+
+    // Between two APU events, the APU cycles only count up, so they are all clocked at once.
+    // A synchronization never goes past the next APU event.
+    const std::uint64_t cycles = (cycle - 1 - apuDeadline) / ApuClockDivider + 1;
+
+    apu.run(cycles);
+    apuDeadline += cycles * ApuClockDivider;
+
+    updateApuEventDeadline();
+}
+
+void Bus::updateApuEventDeadline() {
+    // the master cycle of the APU cycle with the next event
+    apuEventDeadline = apuDeadline + (apu.cyclesUntilEvent() - 1) * ApuClockDivider;
+}
+
+void Bus::writePpuRegister(std::uint16_t addr, std::uint8_t data) {
+    // The PPU exposes eight memory-mapped registers to the CPU.
+    if (addr == 0x2000) {
+        // PPU Controller Register
+        ppu.writeCtrl(data);
+    } else if (addr == 0x2001) {
+        // PPU Mask Register
+        ppu.writeMask(data);
+    } else if (addr == 0x2003) {
+        // PPU OAM Address Register
+        ppu.writeOamAddr(data);
+    } else if (addr == 0x2004) {
+        // PPU OAM Data Register
+        ppu.writeOamData(data);
+    } else if (addr == 0x2005) {
+        // PPU Scroll Data Register
+        ppu.writeScroll(data);
+    } else if (addr == 0x2006) {
+        // PPU Address Register
+        ppu.writeAddr(data);
+    } else if (addr == 0x2007) {
+        // PPU Data Register
+        ppu.writeData(data);
+    } else {
+        // PPU Status Register is read-only. (some games do write these registers?)
+        // assert(0);
+    }
+}
+
+void Bus::startPpuThread() {
+    if (ppuThread != nullptr) {
+        return;
+    }
+
+    ppuRequested = ppuDeadline;
+
+    ppuThread = std::make_unique<PpuThread>();
+    ppuThread->cycle = ppuDeadline;
+    ppuThread->thread = std::thread{&Bus::ppuThreadLoop, this};
+}
+
+void Bus::stopPpuThread() {
+    if (ppuThread == nullptr) {
+        return;
+    }
+
+    pushPpuEvent({.kind = PpuEvent::Kind::Stop});
+    ppuThread->thread.join();
+    ppuThread.reset();
+}
+
+void Bus::pushPpuEvent(PpuEvent event) {
+    PpuThread& thread = *ppuThread;
+
+    while (!thread.events.push(event)) {
+        waitPpu();
+    }
+
+    thread.pushed.store(thread.pushed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    thread.pushed.notify_one();
+
+    if (event.kind == PpuEvent::Kind::Stop) {
+        return;
+    }
+
+    // same steps as runPpu()
+    if (ppuRequested <= event.cycle) {
+        ppuRequested += ((event.cycle - ppuRequested) / PpuClockDivider + 1) * PpuClockDivider;
+    }
+
+    if (ppuRequested - thread.cycle.load(std::memory_order_relaxed) > PpuThreadMaxLag) {
+        waitPpu();
+    }
+}
+
+void Bus::waitPpu() {
+    PpuThread& thread = *ppuThread;
+
+    const std::uint64_t pushed = thread.pushed.load(std::memory_order_relaxed);
+    for (std::uint64_t handled = thread.handled.load(std::memory_order_acquire); handled != pushed; handled = thread.handled.load(std::memory_order_acquire)) {
+        thread.handled.wait(handled, std::memory_order_acquire);
+    }
+}
+
+void Bus::ppuThreadLoop() {
+    PpuThread& thread = *ppuThread;
+
+    for (std::uint64_t handled = 0;; handled++) {
+        PpuEvent event;
+        while (!thread.events.pop(event)) {
+            thread.pushed.wait(handled, std::memory_order_acquire);
+        }
+
+        if (event.kind == PpuEvent::Kind::Stop) {
+            return;
+        }
+
+        runPpu(event.cycle);
+
+        if (event.kind == PpuEvent::Kind::Write) {
+            writePpuRegister(event.addr, event.data);
+        }
+
+        thread.cycle.store(ppuDeadline, std::memory_order_relaxed);
+        thread.handled.store(handled + 1, std::memory_order_release);
+        thread.handled.notify_one();
+    }
+}
+
+Bus::RunResult Bus::runFrame() {
+    if (ppuSyncMode != PpuSyncMode::Lockstep) {
+        return run<true, true>(std::numeric_limits<std::uint64_t>::max());
+    }
+
+    return run<true, false>(std::numeric_limits<std::uint64_t>::max());
+}
+
+Bus::RunResult Bus::runCycles(std::uint64_t cycles) {
+    if (ppuSyncMode != PpuSyncMode::Lockstep) {
+        return run<false, true>(cycles);
+    }
+
+    return run<false, false>(cycles);
+}
+
+template <bool StopAtFrameEnd, bool CatchUp>
+Bus::RunResult Bus::run(std::uint64_t cycles) {
+    RunResult result;
+
+    std::uint64_t begin = masterCycle;
+    std::uint64_t end = cycles < std::numeric_limits<std::uint64_t>::max() - begin ? begin + cycles : std::numeric_limits<std::uint64_t>::max();
+
+    std::uint32_t irqBegin = irqCount;
+    std::uint32_t nmiBegin = nmiCount;
+
+    ppuFrameComplete = false;
+
+    if constexpr (CatchUp) {
+        updatePpuEventDeadline();
+        updateApuEventDeadline();
+    }
+
+    while (masterCycle != end) {
+        tick<CatchUp>();
+        masterCycle = std::min(masterCycle, end);
+
+        if (ppuFrameComplete) {
+            ppuFrameComplete = false;
+            result.frameComplete = true;
+
+            if constexpr (StopAtFrameEnd) {
+                break;
+            }
+        }
+    }
+
+    result.cycles = masterCycle - begin;
+
+    // Leave the PPU and the APU up to date for whoever looks at them between batches,
+    // such as the frontend reading this frame's samples.
+    if (masterCycle != 0) {
+        syncPpu(masterCycle - 1);
+    }
+
+    syncApu(masterCycle);
+
+    result.irqCount = irqCount - irqBegin;
+    result.nmiCount = nmiCount - nmiBegin;
+
+    return result;
+}
+
 void Bus::reset() {
+    masterCycle = 0;
+    ppuDeadline = 0;
+    cpuDeadline = 0;
+    apuDeadline = 0;
+    mapperIrqPending = false;
+
     mapper->reset();
+    mapper->mapPrgPages();
+    mapNameTables();
+    mapChrPages();
     cpu.reset();
     apu.reset();
     ppu.reset();
+
+    ppuRequested = ppuDeadline;
+    updatePpuEventDeadline();
+    updateApuEventDeadline();
+}
+
+void Bus::setPpuSyncMode(PpuSyncMode mode) {
+    if (mode == PpuSyncMode::Threaded) {
+        startPpuThread();
+    } else {
+        stopPpuThread();
+    }
+
+    ppuSyncMode = mode;
 }
 
 Mapper& Bus::getMapper() {
@@ -296,3 +746,7 @@ Joypad& Bus::getJoypad1() {
 Joypad& Bus::getJoypad2() {
     return joypad2;
 }
+
+const PageTable& Bus::getCpuPages() const {
+    return cpuPages;
+}
@@ -9,266 +9,18 @@ namespace {
 bool isCrossed(std::uint16_t a, std::uint16_t b) {
     return (a & 0xFF00) != (b & 0xFF00);
 }
-} // namespace
 
-std::array<CPU::Operation, 256> CPU::opTable{
-    Operation{.name = "BRK", .addressing = Addressing::Imp, .instruction = &CPU::BRK, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "ORA", .addressing = Addressing::Izx, .instruction = &CPU::ORA, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zp0, .instruction = &CPU::NOP, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "ORA", .addressing = Addressing::Zp0, .instruction = &CPU::ORA, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "ASL", .addressing = Addressing::Zp0, .instruction = &CPU::ASL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "PHP", .addressing = Addressing::Imp, .instruction = &CPU::PHP, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "ORA", .addressing = Addressing::Imm, .instruction = &CPU::ORA, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "ASL", .addressing = Addressing::Acc, .instruction = &CPU::ASL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abs, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ORA", .addressing = Addressing::Abs, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ASL", .addressing = Addressing::Abs, .instruction = &CPU::ASL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "BPL", .addressing = Addressing::Rel, .instruction = &CPU::BPL, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "ORA", .addressing = Addressing::Izy, .instruction = &CPU::ORA, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ORA", .addressing = Addressing::Zpx, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ASL", .addressing = Addressing::Zpx, .instruction = &CPU::ASL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "CLC", .addressing = Addressing::Imp, .instruction = &CPU::CLC, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "ORA", .addressing = Addressing::Aby, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "ORA", .addressing = Addressing::Abx, .instruction = &CPU::ORA, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "ASL", .addressing = Addressing::Abx, .instruction = &CPU::ASL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "JSR", .addressing = Addressing::Abs, .instruction = &CPU::JSR, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "AND", .addressing = Addressing::Izx, .instruction = &CPU::AND, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "BIT", .addressing = Addressing::Zp0, .instruction = &CPU::BIT, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "AND", .addressing = Addressing::Zp0, .instruction = &CPU::AND, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "ROL", .addressing = Addressing::Zp0, .instruction = &CPU::ROL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "PLP", .addressing = Addressing::Imp, .instruction = &CPU::PLP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "AND", .addressing = Addressing::Imm, .instruction = &CPU::AND, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "ROL", .addressing = Addressing::Acc, .instruction = &CPU::ROL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "BIT", .addressing = Addressing::Abs, .instruction = &CPU::BIT, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "AND", .addressing = Addressing::Abs, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ROL", .addressing = Addressing::Abs, .instruction = &CPU::ROL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "BMI", .addressing = Addressing::Rel, .instruction = &CPU::BMI, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "AND", .addressing = Addressing::Izy, .instruction = &CPU::AND, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "AND", .addressing = Addressing::Zpx, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ROL", .addressing = Addressing::Zpx, .instruction = &CPU::ROL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "SEC", .addressing = Addressing::Imp, .instruction = &CPU::SEC, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "AND", .addressing = Addressing::Aby, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "AND", .addressing = Addressing::Abx, .instruction = &CPU::AND, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "ROL", .addressing = Addressing::Abx, .instruction = &CPU::ROL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "RTI", .addressing = Addressing::Imp, .instruction = &CPU::RTI, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "EOR", .addressing = Addressing::Izx, .instruction = &CPU::EOR, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zp0, .instruction = &CPU::NOP, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "EOR", .addressing = Addressing::Zp0, .instruction = &CPU::EOR, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "LSR", .addressing = Addressing::Zp0, .instruction = &CPU::LSR, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "PHA", .addressing = Addressing::Imp, .instruction = &CPU::PHA, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "EOR", .addressing = Addressing::Imm, .instruction = &CPU::EOR, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "LSR", .addressing = Addressing::Acc, .instruction = &CPU::LSR, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "JMP", .addressing = Addressing::Abs, .instruction = &CPU::JMP, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "EOR", .addressing = Addressing::Abs, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "LSR", .addressing = Addressing::Abs, .instruction = &CPU::LSR, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "BVC", .addressing = Addressing::Rel, .instruction = &CPU::BVC, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "EOR", .addressing = Addressing::Izy, .instruction = &CPU::EOR, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "EOR", .addressing = Addressing::Zpx, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "LSR", .addressing = Addressing::Zpx, .instruction = &CPU::LSR, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "CLI", .addressing = Addressing::Imp, .instruction = &CPU::CLI, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "EOR", .addressing = Addressing::Aby, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "EOR", .addressing = Addressing::Abx, .instruction = &CPU::EOR, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "LSR", .addressing = Addressing::Abx, .instruction = &CPU::LSR, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "RTS", .addressing = Addressing::Imp, .instruction = &CPU::RTS, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "ADC", .addressing = Addressing::Izx, .instruction = &CPU::ADC, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zp0, .instruction = &CPU::NOP, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "ADC", .addressing = Addressing::Zp0, .instruction = &CPU::ADC, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "ROR", .addressing = Addressing::Zp0, .instruction = &CPU::ROR, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "PLA", .addressing = Addressing::Imp, .instruction = &CPU::PLA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ADC", .addressing = Addressing::Imm, .instruction = &CPU::ADC, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "ROR", .addressing = Addressing::Acc, .instruction = &CPU::ROR, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "JMP", .addressing = Addressing::Ind, .instruction = &CPU::JMP, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "ADC", .addressing = Addressing::Abs, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ROR", .addressing = Addressing::Abs, .instruction = &CPU::ROR, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "BVS", .addressing = Addressing::Rel, .instruction = &CPU::BVS, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "ADC", .addressing = Addressing::Izy, .instruction = &CPU::ADC, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ADC", .addressing = Addressing::Zpx, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "ROR", .addressing = Addressing::Zpx, .instruction = &CPU::ROR, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "SEI", .addressing = Addressing::Imp, .instruction = &CPU::SEI, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "ADC", .addressing = Addressing::Aby, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "ADC", .addressing = Addressing::Abx, .instruction = &CPU::ADC, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "ROR", .addressing = Addressing::Abx, .instruction = &CPU::ROR, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "STA", .addressing = Addressing::Izx, .instruction = &CPU::STA, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "STY", .addressing = Addressing::Zp0, .instruction = &CPU::STY, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "STA", .addressing = Addressing::Zp0, .instruction = &CPU::STA, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "STX", .addressing = Addressing::Zp0, .instruction = &CPU::STX, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "DEY", .addressing = Addressing::Imp, .instruction = &CPU::DEY, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "TXA", .addressing = Addressing::Imp, .instruction = &CPU::TXA, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "STY", .addressing = Addressing::Abs, .instruction = &CPU::STY, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "STA", .addressing = Addressing::Abs, .instruction = &CPU::STA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "STX", .addressing = Addressing::Abs, .instruction = &CPU::STX, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "BCC", .addressing = Addressing::Rel, .instruction = &CPU::BCC, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "STA", .addressing = Addressing::Izy, .instruction = &CPU::STA, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "STY", .addressing = Addressing::Zpx, .instruction = &CPU::STY, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "STA", .addressing = Addressing::Zpx, .instruction = &CPU::STA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "STX", .addressing = Addressing::Zpy, .instruction = &CPU::STX, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpy, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "TYA", .addressing = Addressing::Imp, .instruction = &CPU::TYA, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "STA", .addressing = Addressing::Aby, .instruction = &CPU::STA, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "TXS", .addressing = Addressing::Imp, .instruction = &CPU::TXS, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "STA", .addressing = Addressing::Abx, .instruction = &CPU::STA, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "LDY", .addressing = Addressing::Imm, .instruction = &CPU::LDY, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "LDA", .addressing = Addressing::Izx, .instruction = &CPU::LDA, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "LDX", .addressing = Addressing::Imm, .instruction = &CPU::LDX, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "LDY", .addressing = Addressing::Zp0, .instruction = &CPU::LDY, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "LDA", .addressing = Addressing::Zp0, .instruction = &CPU::LDA, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "LDX", .addressing = Addressing::Zp0, .instruction = &CPU::LDX, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "TAY", .addressing = Addressing::Imp, .instruction = &CPU::TAY, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "LDA", .addressing = Addressing::Imm, .instruction = &CPU::LDA, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "TAX", .addressing = Addressing::Imp, .instruction = &CPU::TAX, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "LDY", .addressing = Addressing::Abs, .instruction = &CPU::LDY, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "LDA", .addressing = Addressing::Abs, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "LDX", .addressing = Addressing::Abs, .instruction = &CPU::LDX, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "BCS", .addressing = Addressing::Rel, .instruction = &CPU::BCS, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "LDA", .addressing = Addressing::Izy, .instruction = &CPU::LDA, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "LDY", .addressing = Addressing::Zpx, .instruction = &CPU::LDY, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "LDA", .addressing = Addressing::Zpx, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "LDX", .addressing = Addressing::Zpy, .instruction = &CPU::LDX, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpy, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "CLV", .addressing = Addressing::Imp, .instruction = &CPU::CLV, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "LDA", .addressing = Addressing::Aby, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "TSX", .addressing = Addressing::Imp, .instruction = &CPU::TSX, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "LDY", .addressing = Addressing::Abx, .instruction = &CPU::LDY, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "LDA", .addressing = Addressing::Abx, .instruction = &CPU::LDA, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "LDX", .addressing = Addressing::Aby, .instruction = &CPU::LDX, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "CPY", .addressing = Addressing::Imm, .instruction = &CPU::CPY, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "CMP", .addressing = Addressing::Izx, .instruction = &CPU::CMP, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "CPY", .addressing = Addressing::Zp0, .instruction = &CPU::CPY, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "CMP", .addressing = Addressing::Zp0, .instruction = &CPU::CMP, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "DEC", .addressing = Addressing::Zp0, .instruction = &CPU::DEC, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "INY", .addressing = Addressing::Imp, .instruction = &CPU::INY, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "CMP", .addressing = Addressing::Imm, .instruction = &CPU::CMP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "DEX", .addressing = Addressing::Imp, .instruction = &CPU::DEX, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Imm, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "CPY", .addressing = Addressing::Abs, .instruction = &CPU::CPY, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "CMP", .addressing = Addressing::Abs, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "DEC", .addressing = Addressing::Abs, .instruction = &CPU::DEC, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "BNE", .addressing = Addressing::Rel, .instruction = &CPU::BNE, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "CMP", .addressing = Addressing::Izy, .instruction = &CPU::CMP, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "CMP", .addressing = Addressing::Zpx, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "DEC", .addressing = Addressing::Zpx, .instruction = &CPU::DEC, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "CLD", .addressing = Addressing::Imp, .instruction = &CPU::CLD, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "CMP", .addressing = Addressing::Aby, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "CMP", .addressing = Addressing::Abx, .instruction = &CPU::CMP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "DEC", .addressing = Addressing::Abx, .instruction = &CPU::DEC, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "CPX", .addressing = Addressing::Imm, .instruction = &CPU::CPX, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Izx, .instruction = &CPU::SBC, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Imm, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izx, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "CPX", .addressing = Addressing::Zp0, .instruction = &CPU::CPX, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Zp0, .instruction = &CPU::SBC, .cycle = 3, .pageCycle = 0},
-    Operation{.name = "INC", .addressing = Addressing::Zp0, .instruction = &CPU::INC, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zp0, .instruction = &CPU::NIL, .cycle = 5, .pageCycle = 0},
-    Operation{.name = "INX", .addressing = Addressing::Imp, .instruction = &CPU::INX, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Imm, .instruction = &CPU::SBC, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Imm, .instruction = &CPU::SBC, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "CPX", .addressing = Addressing::Abs, .instruction = &CPU::CPX, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Abs, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "INC", .addressing = Addressing::Abs, .instruction = &CPU::INC, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abs, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "BEQ", .addressing = Addressing::Rel, .instruction = &CPU::BEQ, .cycle = 2, .pageCycle = 1},
-    Operation{.name = "SBC", .addressing = Addressing::Izy, .instruction = &CPU::SBC, .cycle = 5, .pageCycle = 1},
-    Operation{.name = "???", .addressing = Addressing::Imp, .instruction = &CPU::NIL, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Izy, .instruction = &CPU::NIL, .cycle = 8, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Zpx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Zpx, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 0},
-    Operation{.name = "INC", .addressing = Addressing::Zpx, .instruction = &CPU::INC, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Zpx, .instruction = &CPU::NIL, .cycle = 6, .pageCycle = 0},
-    Operation{.name = "SED", .addressing = Addressing::Imp, .instruction = &CPU::SED, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "SBC", .addressing = Addressing::Aby, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "NOP", .addressing = Addressing::Imp, .instruction = &CPU::NOP, .cycle = 2, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Aby, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "NOP", .addressing = Addressing::Abx, .instruction = &CPU::NOP, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "SBC", .addressing = Addressing::Abx, .instruction = &CPU::SBC, .cycle = 4, .pageCycle = 1},
-    Operation{.name = "INC", .addressing = Addressing::Abx, .instruction = &CPU::INC, .cycle = 7, .pageCycle = 0},
-    Operation{.name = "???", .addressing = Addressing::Abx, .instruction = &CPU::NIL, .cycle = 7, .pageCycle = 0},
-};
+// The zero (bit 1) and negative (bit 7) flags of every 8-bit value.
+constexpr std::array<std::uint8_t, 256> zeroNegativeFlags = [] {
+    std::array<std::uint8_t, 256> res{};
+
+    for (int i = 0; i != 256; i++) {
+        res[i] = (i == 0 ? 0x02 : 0x00) | (i & 0x80);
+    }
+
+    return res;
+}();
+} // namespace
 
 void CPU::connect(Bus* bus) {
     this->bus = bus;
@@ -276,14 +28,29 @@ void CPU::connect(Bus* bus) {
 }
 
 void CPU::clock() {
+    latchInterrupts = false;
+
     // execute the operation at last cycle
-    if (cycles == 0) {
+    if (!takeInterrupt() && cycles == 0) {
         step();
     }
 
     cycles--;
 }
 
+std::uint8_t CPU::stepInstruction() {
+    latchInterrupts = true;
+
+    if (!takeInterrupt() && cycles == 0) {
+        step();
+    }
+
+    std::uint8_t res = cycles;
+    cycles = 0;
+
+    return res;
+}
+
 void CPU::reset() {
     pc = read16(0xFFFC);
     a = 0;
@@ -294,30 +61,47 @@ void CPU::reset() {
     status.reg = 0x24;
 
     cycles = 8;
-}
 
-void CPU::nmi() {
-    push16(pc);
-    push(status.reg);
+    nmiPending = false;
+    irqPending = false;
 
-    status.i = 1;
+    invalidateCode();
+}
 
-    pc = read16(0xFFFA);
+void CPU::invalidateRamCode(std::uint16_t addr) {
+    // The written byte may be the opcode or an operand of an instruction.
+    for (std::uint16_t i = 0; i != 3; i++) {
+        ramCodeCache[(addr - i) & 0x07FF].generation = 0;
+    }
+}
 
-    cycles = 8;
+void CPU::invalidateCode() {
+    prgCodeGeneration++;
+    ramCodeGeneration++;
 }
 
-void CPU::irq() {
-    if (status.i == 0) {
-        push16(pc);
-        push(status.reg);
+bool CPU::nmi() {
+    if (latchInterrupts) {
+        nmiPending = true;
+        return true;
+    }
 
-        status.i = 1;
+    interrupt(0xFFFA, 8);
+    return false;
+}
 
-        pc = read16(0xFFFE);
+bool CPU::irq() {
+    if (status.i != 0) {
+        return false;
+    }
 
-        cycles = 7;
+    if (latchInterrupts) {
+        irqPending = true;
+        return true;
     }
+
+    interrupt(0xFFFE, 7);
+    return false;
 }
 
 void CPU::serialize(std::ostream& os) const {
@@ -330,6 +114,8 @@ void CPU::deserialize(std::istream& is) {
     auto begin = reinterpret_cast<char*>(this) + offsetof(CPU, pc);
     auto end = reinterpret_cast<char*>(this) + offsetof(CPU, bus);
     is.read(begin, end - begin);
+
+    invalidateCode();
 }
 
 void CPU::setPc(std::uint16_t newPc) {
@@ -358,82 +144,190 @@ std::string CPU::debugStr() {
 }
 
 void CPU::step() {
-    opcode = read(pc++);
+    const DecodedInstruction& inst = fetch();
+    Handler handler = inst.handler;
+    std::uint16_t operand = inst.operand;
 
-    std::uint16_t address = 0;
-    bool pageCrossed = false;
+    opcode = inst.opcode;
+    pc += inst.length;
+    handler(*this, operand);
+
+    totalCycles += cycles;
+}
+
+const CPU::DecodedInstruction& CPU::fetch() {
+    // An instruction is only cached if all of its bytes lie in the same cached region.
+    if (pc >= 0x8000 && pc <= 0xFFFD) {
+        const PageTable& pages = bus->getCpuPages();
+        std::size_t pageIndex = pc / PageTable::PageSize;
+        std::size_t offset = pc % PageTable::PageSize;
+
+        if (const std::uint8_t* page = pages.read[pageIndex]) {
+            DecodedInstruction& entry = prgCodeCache[pc & 0x7FFF];
+
+            // The entry decodes the same PRG ROM bytes if the opcode is read from the same byte of the same bank,
+            // and an operand in the next page is read from the page that follows it in that bank.
+            bool valid = entry.generation == prgCodeGeneration && entry.code == page + offset
+                         && (offset + entry.length <= PageTable::PageSize || pages.read[pageIndex + 1] == page + PageTable::PageSize);
 
-    const Operation& op = opTable[opcode];
+            if (!valid) {
+                decode(entry);
+                entry.generation = prgCodeGeneration;
+                entry.code = page + offset;
+            }
 
-    switch (op.addressing) {
+            return entry;
+        }
+    } else if (pc < 0x1FFE) {
+        DecodedInstruction& entry = ramCodeCache[pc & 0x07FF];
+
+        if (entry.generation != ramCodeGeneration) {
+            decode(entry);
+            entry.generation = ramCodeGeneration;
+        }
+
+        return entry;
+    }
+
+    decode(uncachedInstruction);
+    return uncachedInstruction;
+}
+
+void CPU::decode(DecodedInstruction& inst) {
+    inst.opcode = read(pc);
+    inst.handler = handlers[inst.opcode];
+
+    switch (opTable[inst.opcode].addressing) {
     case Addressing::Imp:
     case Addressing::Acc:
-        // ignore
+        inst.length = 1;
+        inst.operand = 0;
         break;
     case Addressing::Imm:
-        address = pc++;
+        // the operand is read by the instruction itself
+        inst.length = 2;
+        inst.operand = 0;
         break;
     case Addressing::Zp0:
-        address = read(pc++) & 0x00FF;
-        break;
     case Addressing::Zpx:
-        address = (read(pc++) + x) & 0x00FF;
-        break;
     case Addressing::Zpy:
-        address = (read(pc++) + y) & 0x00FF;
-        break;
     case Addressing::Rel:
-        address = read(pc++);
-        if (address & 0x80) {
-            address |= 0xFF00;
-        }
+    case Addressing::Izx:
+    case Addressing::Izy:
+        inst.length = 2;
+        inst.operand = read(pc + 1);
         break;
     case Addressing::Abs:
-        address = read16(pc);
-        pc += 2;
-        break;
     case Addressing::Abx:
-        address = read16(pc) + x;
-        pc += 2;
-        pageCrossed = isCrossed(address - x, address);
-        break;
     case Addressing::Aby:
-        address = read16(pc) + y;
-        pc += 2;
-        pageCrossed = isCrossed(address - y, address);
+    case Addressing::Ind:
+        inst.length = 3;
+        inst.operand = read16(pc + 1);
         break;
-    case Addressing::Ind: {
-        std::uint16_t ptr = read16(pc);
-        pc += 2;
+    default:
+        assert(0);
+    }
+}
+
+template <std::uint8_t Opcode>
+void CPU::execute(CPU& cpu, std::uint16_t operand) {
+    constexpr Operation op = opTable[Opcode];
+
+    bool pageCrossed = false;
+    std::uint16_t address = cpu.fetchAddress<op.addressing>(operand, pageCrossed);
+
+    (cpu.*op.instruction)(address);
+    cpu.cycles += op.cycle;
+
+    if constexpr (op.pageCycle != 0) {
+        if (pageCrossed) {
+            cpu.cycles += op.pageCycle;
+        }
+    }
+}
+
+template <std::size_t... Opcodes>
+constexpr std::array<CPU::Handler, sizeof...(Opcodes)> CPU::makeHandlers(std::index_sequence<Opcodes...>) {
+    return {&CPU::execute<Opcodes>...};
+}
+
+const std::array<CPU::Handler, 256> CPU::handlers = CPU::makeHandlers(std::make_index_sequence<256>{});
 
-        if ((ptr & 0x00FF) == 0x00FF) {
-            address = read(ptr & 0xFF00) << 8 | read(ptr);
+template <CPU::Addressing Mode>
+std::uint16_t CPU::fetchAddress(std::uint16_t operand, bool& pageCrossed) {
+    // pc already points to the next instruction.
+    std::uint16_t address = 0;
+
+    if constexpr (Mode == Addressing::Imp || Mode == Addressing::Acc) {
+        // ignore
+    } else if constexpr (Mode == Addressing::Imm) {
+        address = pc - 1;
+    } else if constexpr (Mode == Addressing::Zp0) {
+        address = operand & 0x00FF;
+    } else if constexpr (Mode == Addressing::Zpx) {
+        address = (operand + x) & 0x00FF;
+    } else if constexpr (Mode == Addressing::Zpy) {
+        address = (operand + y) & 0x00FF;
+    } else if constexpr (Mode == Addressing::Rel) {
+        address = operand;
+        if (address & 0x80) {
+            address |= 0xFF00;
+        }
+    } else if constexpr (Mode == Addressing::Abs) {
+        address = operand;
+    } else if constexpr (Mode == Addressing::Abx) {
+        address = operand + x;
+        pageCrossed = isCrossed(operand, address);
+    } else if constexpr (Mode == Addressing::Aby) {
+        address = operand + y;
+        pageCrossed = isCrossed(operand, address);
+    } else if constexpr (Mode == Addressing::Ind) {
+        if ((operand & 0x00FF) == 0x00FF) {
+            address = read(operand & 0xFF00) << 8 | read(operand);
         } else {
-            address = read(ptr + 1) << 8 | read(ptr);
+            address = read(operand + 1) << 8 | read(operand);
         }
-    } break;
-    case Addressing::Izx: {
-        std::uint16_t temp = read(pc++);
-        address = read((temp + x + 1) & 0x00FF) << 8 | read((temp + x) & 0x00FF);
-    } break;
-    case Addressing::Izy: {
-        std::uint16_t temp = read(pc++);
-        address = read((temp + 1) & 0x00FF) << 8 | read(temp & 0x00FF);
+    } else if constexpr (Mode == Addressing::Izx) {
+        address = read((operand + x + 1) & 0x00FF) << 8 | read((operand + x) & 0x00FF);
+    } else if constexpr (Mode == Addressing::Izy) {
+        address = read((operand + 1) & 0x00FF) << 8 | read(operand & 0x00FF);
         address += y;
         pageCrossed = isCrossed(address - y, address);
-    } break;
-    default:
-        assert(0);
     }
 
-    (this->*op.instruction)(address);
-    cycles += op.cycle;
+    return address;
+}
+
+void CPU::updateZN(std::uint8_t value) {
+    status.reg = (status.reg & ~0x82) | zeroNegativeFlags[value];
+}
+
+bool CPU::takeInterrupt() {
+    if (nmiPending) {
+        nmiPending = false;
+        interrupt(0xFFFA, 8);
+        return true;
+    }
 
-    if (pageCrossed) {
-        cycles += op.pageCycle;
+    if (irqPending) {
+        irqPending = false;
+        interrupt(0xFFFE, 7);
+        return true;
     }
 
-    totalCycles += cycles;
+    return false;
+}
+
+void CPU::interrupt(std::uint16_t vector, std::uint8_t interruptCycles) {
+    push16(pc);
+    push(status.reg);
+
+    status.i = 1;
+
+    pc = read16(vector);
+
+    // The cycles left of the current instruction are dropped.
+    cycles = interruptCycles;
 }
 
 std::uint8_t CPU::read(std::uint16_t addr) {
@@ -479,29 +373,26 @@ void CPU::ADC(std::uint16_t address) {
     status.v = ((a ^ sum) & (m ^ sum) & 0x80 ? 1 : 0);
 
     a = std::uint8_t(sum);
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::AND(std::uint16_t address) {
     a = a & read(address);
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
+template <CPU::Addressing Mode>
 void CPU::ASL(std::uint16_t address) {
-    if (opTable[opcode].addressing == Addressing::Acc) {
+    if constexpr (Mode == Addressing::Acc) {
         status.c = (a >> 7) & 1;
         a <<= 1;
-        status.z = (a == 0 ? 1 : 0);
-        status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(a);
     } else {
         std::uint8_t m = read(address);
         status.c = (m >> 7) & 1;
         m <<= 1;
         write(address, m);
-        status.z = (m == 0 ? 1 : 0);
-        status.n = (((m >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(m);
     }
 }
 
@@ -613,22 +504,19 @@ void CPU::CLV(std::uint16_t) {
 void CPU::CMP(std::uint16_t address) {
     std::uint8_t m = read(address);
     status.c = (a >= m ? 1 : 0);
-    status.z = (a == m ? 1 : 0);
-    status.n = ((((a - m) >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a - m);
 }
 
 void CPU::CPX(std::uint16_t address) {
     std::uint8_t m = read(address);
     status.c = (x >= m ? 1 : 0);
-    status.z = (x == m ? 1 : 0);
-    status.n = ((((x - m) >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(x - m);
 }
 
 void CPU::CPY(std::uint16_t address) {
     std::uint8_t m = read(address);
     status.c = (y >= m ? 1 : 0);
-    status.z = (y == m ? 1 : 0);
-    status.n = ((((y - m) >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(y - m);
 }
 
 void CPU::DEC(std::uint16_t address) {
@@ -636,26 +524,22 @@ void CPU::DEC(std::uint16_t address) {
     m--;
     write(address, m);
 
-    status.z = (m == 0 ? 1 : 0);
-    status.n = (((m >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(m);
 }
 
 void CPU::DEX(std::uint16_t) {
     x--;
-    status.z = (x == 0 ? 1 : 0);
-    status.n = (((x >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(x);
 }
 
 void CPU::DEY(std::uint16_t) {
     y--;
-    status.z = (y == 0 ? 1 : 0);
-    status.n = (((y >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(y);
 }
 
 void CPU::EOR(std::uint16_t address) {
     a = a ^ read(address);
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::INC(std::uint16_t address) {
@@ -663,20 +547,17 @@ void CPU::INC(std::uint16_t address) {
     m++;
     write(address, m);
 
-    status.z = (m == 0 ? 1 : 0);
-    status.n = (((m >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(m);
 }
 
 void CPU::INX(std::uint16_t) {
     x++;
-    status.z = (x == 0 ? 1 : 0);
-    status.n = (((x >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(x);
 }
 
 void CPU::INY(std::uint16_t) {
     y++;
-    status.z = (y == 0 ? 1 : 0);
-    status.n = (((y >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(y);
 }
 
 void CPU::JMP(std::uint16_t address) {
@@ -690,35 +571,31 @@ void CPU::JSR(std::uint16_t address) {
 
 void CPU::LDA(std::uint16_t address) {
     a = read(address);
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::LDX(std::uint16_t address) {
     x = read(address);
-    status.z = (x == 0 ? 1 : 0);
-    status.n = (((x >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(x);
 }
 
 void CPU::LDY(std::uint16_t address) {
     y = read(address);
-    status.z = (y == 0 ? 1 : 0);
-    status.n = (((y >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(y);
 }
 
+template <CPU::Addressing Mode>
 void CPU::LSR(std::uint16_t address) {
-    if (opTable[opcode].addressing == Addressing::Acc) {
+    if constexpr (Mode == Addressing::Acc) {
         status.c = a & 1;
         a >>= 1;
-        status.z = (a == 0 ? 1 : 0);
-        status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(a);
     } else {
         std::uint8_t m = read(address);
         status.c = m & 1;
         m >>= 1;
         write(address, m);
-        status.z = (m == 0 ? 1 : 0);
-        status.n = (((m >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(m);
     }
 }
 
@@ -728,8 +605,7 @@ void CPU::NOP(std::uint16_t) {
 
 void CPU::ORA(std::uint16_t address) {
     a = a | read(address);
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::PHA(std::uint16_t) {
@@ -742,47 +618,44 @@ void CPU::PHP(std::uint16_t) {
 
 void CPU::PLA(std::uint16_t) {
     a = pop();
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::PLP(std::uint16_t) {
     status.reg = pop() & 0xEF | 0x20;
 }
 
+template <CPU::Addressing Mode>
 void CPU::ROL(std::uint16_t address) {
-    if (opTable[opcode].addressing == Addressing::Acc) {
+    if constexpr (Mode == Addressing::Acc) {
         std::uint8_t oldC = status.c;
         status.c = (a >> 7) & 1;
         a = (a << 1) | oldC;
-        status.z = (a == 0 ? 1 : 0);
-        status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(a);
     } else {
         std::uint8_t m = read(address);
         std::uint8_t oldC = status.c;
         status.c = (m >> 7) & 1;
         m = (m << 1) | oldC;
         write(address, m);
-        status.z = (m == 0 ? 1 : 0);
-        status.n = (((m >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(m);
     }
 }
 
+template <CPU::Addressing Mode>
 void CPU::ROR(std::uint16_t address) {
-    if (opTable[opcode].addressing == Addressing::Acc) {
+    if constexpr (Mode == Addressing::Acc) {
         std::uint8_t oldC = status.c;
         status.c = a & 1;
         a = (a >> 1) | (oldC << 7);
-        status.z = (a == 0 ? 1 : 0);
-        status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(a);
     } else {
         std::uint8_t m = read(address);
         std::uint8_t oldC = status.c;
         status.c = m & 1;
         m = (m >> 1) | (oldC << 7);
         write(address, m);
-        status.z = (m == 0 ? 1 : 0);
-        status.n = (((m >> 7) & 1) == 1 ? 1 : 0);
+        updateZN(m);
     }
 }
 
@@ -803,8 +676,7 @@ void CPU::SBC(std::uint16_t address) {
     status.v = ((a ^ diff) & (~m ^ diff) & 0x80 ? 1 : 0);
 
     a = std::uint8_t(diff);
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::SEC(std::uint16_t) {
@@ -833,26 +705,22 @@ void CPU::STY(std::uint16_t address) {
 
 void CPU::TAX(std::uint16_t) {
     x = a;
-    status.z = (x == 0 ? 1 : 0);
-    status.n = (((x >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(x);
 }
 
 void CPU::TAY(std::uint16_t) {
     y = a;
-    status.z = (y == 0 ? 1 : 0);
-    status.n = (((y >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(y);
 }
 
 void CPU::TSX(std::uint16_t) {
     x = sp;
-    status.z = (x == 0 ? 1 : 0);
-    status.n = (((x >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(x);
 }
 
 void CPU::TXA(std::uint16_t) {
     a = x;
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::TXS(std::uint16_t) {
@@ -861,8 +729,7 @@ void CPU::TXS(std::uint16_t) {
 
 void CPU::TYA(std::uint16_t) {
     a = y;
-    status.z = (a == 0 ? 1 : 0);
-    status.n = (((a >> 7) & 1) == 1 ? 1 : 0);
+    updateZN(a);
 }
 
 void CPU::NIL(std::uint16_t) {
@@ -31,6 +31,15 @@ void Mapper::reset() {
     // do nothing
 }
 
+void Mapper::connect(PageTable* cpuPages) {
+    this->cpuPages = cpuPages;
+    mapPrgPages();
+}
+
+void Mapper::mapPrgPages() {
+    // do nothing
+}
+
 void Mapper::serialize(std::ostream& os) const {
     // do nothing
 }
@@ -43,6 +52,10 @@ Mirroring Mapper::mirroring() const {
     return cartridge.mirroring;
 }
 
+std::span<const std::uint8_t> Mapper::chr() const {
+    return cartridge.chrRom;
+}
+
 std::uint8_t Mapper::prgBanks() const {
     return cartridge.prgBanks;
 }
@@ -59,6 +72,10 @@ void Mapper::irqClear() {
     // do nothing
 }
 
+bool Mapper::countsScanlines() const {
+    return false;
+}
+
 void Mapper::scanline() {
     // do nothing
 }
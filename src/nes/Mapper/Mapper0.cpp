@@ -1,6 +1,7 @@
 #include <cassert>
 
 #include <nes/Mapper/Mapper0.h>
+#include <nes/literals.h>
 
 std::uint8_t Mapper0::cpuRead(std::uint16_t addr) {
     std::uint32_t mappedAddr = 0;
@@ -23,11 +24,23 @@ void Mapper0::cpuWrite(std::uint16_t addr, std::uint8_t data) {
     assert(0);
 }
 
+void Mapper0::mapPrgPages() {
+    // 16 KB PRG ROM is mirrored at $C000
+    const std::uint8_t* prgRom = cartridge.prgRom.data();
+    cpuPages->mapRead(0x8000, 16_kb, prgRom);
+    cpuPages->mapRead(0xC000, 16_kb, prgBanks() == 1 ? prgRom : prgRom + 16_kb);
+}
+
 std::uint8_t Mapper0::ppuRead(std::uint16_t addr) {
     assert(addr >= 0 && addr < 0x2000);
     return cartridge.chrRom[addr];
 }
 
+std::uint32_t Mapper0::chrOffset(std::uint16_t addr) const {
+    assert(addr >= 0 && addr < 0x2000);
+    return addr;
+}
+
 void Mapper0::ppuWrite(std::uint16_t addr, std::uint8_t data) {
     assert(addr >= 0 && addr < 0x2000);
     cartridge.chrRom[addr] = data;
@@ -47,22 +47,22 @@ void Mapper1::cpuWrite(std::uint16_t addr, std::uint8_t data) {
     }
 
     if (addr >= 0x8000 && addr <= 0xFFFF) {
-        static std::uint8_t count = 0;
-
         // Load Register
         if (data & 0x80) {
             // Reset shift register and write Control with (Control OR $0C),
             // locking PRG ROM at $C000-$FFFF to the last bank.
             loadRegister = 0;
             controlRegister |= 0x0C;
-            count = 0;
+            loadCount = 0;
+
+            mapPrgPages();
         } else {
             loadRegister >>= 1;
             loadRegister |= (data & 0b1) << 4;
-            count++;
+            loadCount++;
 
-            if (count == 5) {
-                count = 0;
+            if (loadCount == 5) {
+                loadCount = 0;
 
                 std::uint8_t targetRegister = (addr >> 13) & 0x03;
                 if (targetRegister == 0) {
@@ -78,16 +78,49 @@ void Mapper1::cpuWrite(std::uint16_t addr, std::uint8_t data) {
                 }
 
                 loadRegister = 0;
+
+                if (targetRegister == 0 || targetRegister == 3) {
+                    mapPrgPages();
+                }
             }
         }
     }
 }
 
+void Mapper1::mapPrgPages() {
+    cpuPages->mapRead(0x6000, 8_kb, prgRam.data());
+    cpuPages->mapWrite(0x6000, 8_kb, prgRam.data());
+
+    // Same bank selection as cpuRead(), wrapped to the PRG ROM size.
+    const std::uint8_t* prgRom = cartridge.prgRom.data();
+    std::uint8_t mode = (controlRegister >> 2) & 0b11;
+
+    if (mode == 0 || mode == 1) {
+        std::uint16_t selectedPrgBank = (prgBank >> 1) & 0b111;
+        cpuPages->mapRead(0x8000, 32_kb, prgRom + (selectedPrgBank * 32_kb) % cartridge.prgRom.size());
+    } else if (mode == 2) {
+        std::uint16_t selectedPrgBank = prgBank & 0b1111;
+        cpuPages->mapRead(0x8000, 16_kb, prgRom);
+        cpuPages->mapRead(0xC000, 16_kb, prgRom + (selectedPrgBank % prgBanks()) * 16_kb);
+    } else if (mode == 3) {
+        std::uint16_t selectedPrgBank = prgBank & 0b1111;
+        cpuPages->mapRead(0x8000, 16_kb, prgRom + (selectedPrgBank % prgBanks()) * 16_kb);
+        cpuPages->mapRead(0xC000, 16_kb, prgRom + (prgBanks() - 1) * 16_kb);
+    }
+}
+
 std::uint8_t Mapper1::ppuRead(std::uint16_t addr) {
+    std::uint32_t mappedAddr = chrOffset(addr);
+    assert(mappedAddr >= 0 && mappedAddr < cartridge.chrRom.size());
+
+    return cartridge.chrRom[mappedAddr];
+}
+
+std::uint32_t Mapper1::chrOffset(std::uint16_t addr) const {
     assert(addr >= 0 && addr < 0x2000);
 
     if (chrBanks() == 0) {
-        return cartridge.chrRom[addr];
+        return addr;
     }
 
     std::uint32_t mappedAddr = 0;
@@ -113,8 +146,7 @@ std::uint8_t Mapper1::ppuRead(std::uint16_t addr) {
         }
     }
 
-    assert(mappedAddr >= 0 && mappedAddr < cartridge.chrRom.size());
-    return cartridge.chrRom[mappedAddr];
+    return mappedAddr;
 }
 
 void Mapper1::ppuWrite(std::uint16_t addr, std::uint8_t data) {
@@ -129,6 +161,7 @@ void Mapper1::ppuWrite(std::uint16_t addr, std::uint8_t data) {
 
 void Mapper1::reset() {
     loadRegister = 0;
+    loadCount = 0;
     controlRegister = 0x1C;
 
     chrBank0 = 0;
@@ -144,6 +177,7 @@ void Mapper1::serialize(std::ostream& os) const {
     }
 
     os.write(reinterpret_cast<const char*>(&loadRegister), sizeof loadRegister);
+    os.write(reinterpret_cast<const char*>(&loadCount), sizeof loadCount);
     os.write(reinterpret_cast<const char*>(&controlRegister), sizeof controlRegister);
     os.write(reinterpret_cast<const char*>(&chrBank0), sizeof chrBank0);
     os.write(reinterpret_cast<const char*>(&chrBank1), sizeof chrBank1);
@@ -158,6 +192,7 @@ void Mapper1::deserialize(std::istream& is) {
     }
 
     is.read(reinterpret_cast<char*>(&loadRegister), sizeof loadRegister);
+    is.read(reinterpret_cast<char*>(&loadCount), sizeof loadCount);
     is.read(reinterpret_cast<char*>(&controlRegister), sizeof controlRegister);
     is.read(reinterpret_cast<char*>(&chrBank0), sizeof chrBank0);
     is.read(reinterpret_cast<char*>(&chrBank1), sizeof chrBank1);
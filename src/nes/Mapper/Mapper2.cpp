@@ -1,6 +1,7 @@
 #include <cassert>
 
 #include <nes/Mapper/Mapper2.h>
+#include <nes/literals.h>
 
 std::uint8_t Mapper2::cpuRead(std::uint16_t addr) {
     std::uint32_t mappedAddr = 0;
@@ -18,14 +19,26 @@ std::uint8_t Mapper2::cpuRead(std::uint16_t addr) {
 void Mapper2::cpuWrite(std::uint16_t addr, std::uint8_t data) {
     if (addr >= 0x8000 && addr <= 0xFFFF) {
         bankSelect = data & 0b1111;
+        mapPrgPages();
     }
 }
 
+void Mapper2::mapPrgPages() {
+    const std::uint8_t* prgRom = cartridge.prgRom.data();
+    cpuPages->mapRead(0x8000, 16_kb, prgRom + (bankSelect % prgBanks()) * 16_kb);
+    cpuPages->mapRead(0xC000, 16_kb, prgRom + (prgBanks() - 1) * 16_kb);
+}
+
 std::uint8_t Mapper2::ppuRead(std::uint16_t addr) {
     assert(addr >= 0 && addr < 0x2000);
     return cartridge.chrRom[addr];
 }
 
+std::uint32_t Mapper2::chrOffset(std::uint16_t addr) const {
+    assert(addr >= 0 && addr < 0x2000);
+    return addr;
+}
+
 void Mapper2::ppuWrite(std::uint16_t addr, std::uint8_t data) {
     assert(addr >= 0 && addr < 0x2000);
     assert(chrBanks() == 0);
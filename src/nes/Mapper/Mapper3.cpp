@@ -1,6 +1,7 @@
 #include <cassert>
 
 #include <nes/Mapper/Mapper3.h>
+#include <nes/literals.h>
 
 std::uint8_t Mapper3::cpuRead(std::uint16_t addr) {
     std::uint32_t mappedAddr = 0;
@@ -27,7 +28,21 @@ void Mapper3::cpuWrite(std::uint16_t addr, std::uint8_t data) {
     }
 }
 
+void Mapper3::mapPrgPages() {
+    // 16 KB PRG ROM is mirrored at $C000
+    const std::uint8_t* prgRom = cartridge.prgRom.data();
+    cpuPages->mapRead(0x8000, 16_kb, prgRom);
+    cpuPages->mapRead(0xC000, 16_kb, prgBanks() == 1 ? prgRom : prgRom + 16_kb);
+}
+
 std::uint8_t Mapper3::ppuRead(std::uint16_t addr) {
+    std::uint32_t mappedAddr = chrOffset(addr);
+    assert(mappedAddr >= 0 && mappedAddr < cartridge.chrRom.size());
+
+    return cartridge.chrRom[mappedAddr];
+}
+
+std::uint32_t Mapper3::chrOffset(std::uint16_t addr) const {
     assert(addr >= 0 && addr < 0x2000);
 
     std::uint32_t mappedAddr = 0;
@@ -36,8 +51,7 @@ std::uint8_t Mapper3::ppuRead(std::uint16_t addr) {
         mappedAddr = bankSelect * 0x2000 + addr;
     }
 
-    assert(mappedAddr >= 0 && mappedAddr < cartridge.chrRom.size());
-    return cartridge.chrRom[mappedAddr];
+    return mappedAddr;
 }
 
 void Mapper3::ppuWrite(std::uint16_t addr, std::uint8_t data) {
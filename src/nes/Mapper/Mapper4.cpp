@@ -48,6 +48,8 @@ void Mapper4::cpuWrite(std::uint16_t addr, std::uint8_t data) {
             // Bank select ($8000-$9FFE, even)
             bankSelect = data;
         }
+
+        mapPrgPages();
     } else if (addr >= 0xA000 && addr < 0xC000) {
         if (addr & 1) {
             // PRG RAM protect ($A001-$BFFF, odd)
@@ -76,7 +78,32 @@ void Mapper4::cpuWrite(std::uint16_t addr, std::uint8_t data) {
     }
 }
 
+void Mapper4::mapPrgPages() {
+    cpuPages->mapRead(0x6000, 8_kb, prgRam.data());
+    cpuPages->mapWrite(0x6000, 8_kb, prgRam.data());
+
+    // Same bank selection as cpuRead().
+    const std::uint8_t* prgRom = cartridge.prgRom.data();
+    std::uint8_t d6 = (bankSelect >> 6) & 1;
+    std::uint32_t secondLastBank = (prgBanks() * 2 - 2) * 8_kb;
+    std::uint32_t lastBank = (prgBanks() * 2 - 1) * 8_kb;
+    std::uint32_t bank6 = (bankRegister[6] & (prgBanks() * 2 - 1)) * 8_kb;
+    std::uint32_t bank7 = (bankRegister[7] & (prgBanks() * 2 - 1)) * 8_kb;
+
+    cpuPages->mapRead(0x8000, 8_kb, prgRom + (d6 ? secondLastBank : bank6));
+    cpuPages->mapRead(0xA000, 8_kb, prgRom + bank7);
+    cpuPages->mapRead(0xC000, 8_kb, prgRom + (d6 ? bank6 : secondLastBank));
+    cpuPages->mapRead(0xE000, 8_kb, prgRom + lastBank);
+}
+
 std::uint8_t Mapper4::ppuRead(std::uint16_t addr) {
+    std::uint32_t mappedAddr = chrOffset(addr);
+    assert(mappedAddr >= 0 && mappedAddr < cartridge.chrRom.size());
+
+    return cartridge.chrRom[mappedAddr];
+}
+
+std::uint32_t Mapper4::chrOffset(std::uint16_t addr) const {
     assert(addr >= 0 && addr < 0x2000);
 
     std::uint32_t baseAddr = 0;
@@ -132,10 +159,7 @@ std::uint8_t Mapper4::ppuRead(std::uint16_t addr) {
         }
     }
 
-    std::uint32_t mappedAddr = baseAddr + (addr & 0x03FF);
-    assert(mappedAddr >= 0 && mappedAddr < cartridge.chrRom.size());
-
-    return cartridge.chrRom[mappedAddr];
+    return baseAddr + (addr & 0x03FF);
 }
 
 void Mapper4::ppuWrite(std::uint16_t addr, std::uint8_t data) {
@@ -181,6 +205,11 @@ void Mapper4::deserialize(std::istream& is) {
 }
 
 Mirroring Mapper4::mirroring() const {
+    // Boards with four-screen VRAM ignore the mirroring register
+    if (cartridge.mirroring == Mirroring::FourScreen) {
+        return Mirroring::FourScreen;
+    }
+
     return (mirror & 0b1) ? Mirroring::Horizontal : Mirroring::Vertical;
 }
 
@@ -192,6 +221,10 @@ void Mapper4::irqClear() {
     irqActive = false;
 }
 
+bool Mapper4::countsScanlines() const {
+    return true;
+}
+
 void Mapper4::scanline() {
     if (irqCounter == 0) {
         irqCounter = irqReload;
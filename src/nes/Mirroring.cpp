@@ -12,6 +12,8 @@ std::string_view description(Mirroring mirroring) {
         return "vertical";
     case Mirroring::Horizontal:
         return "horizontal";
+    case Mirroring::FourScreen:
+        return "four-screen";
     }
 
     assert(0);
@@ -55,7 +55,10 @@ std::optional<Cartridge> loadNesFile(std::string_view path) {
     // mirroring type
     Mirroring mirroringType;
 
-    if (header.flag6 & 1) {
+    if ((header.flag6 >> 3) & 1) {
+        // ignore mirroring control or above mirroring bit; instead provide four-screen VRAM
+        mirroringType = Mirroring::FourScreen;
+    } else if (header.flag6 & 1) {
         mirroringType = Mirroring::Vertical;
     } else {
         mirroringType = Mirroring::Horizontal;
@@ -79,11 +82,6 @@ std::optional<Cartridge> loadNesFile(std::string_view path) {
         std::cout << "Has trainer";
     }
 
-    // ignore mirroring control
-    if ((header.flag6 >> 3) & 1) {
-        std::cout << "Ignore mirroring control or above mirroring bit; instead provide four-screen VRAM\n";
-    }
-
     // prg rom data
     std::vector<std::uint8_t> prgRom(header.prgSize * 16_kb);
     nesFile.read(reinterpret_cast<char*>(prgRom.data()), prgRom.size());
@@ -1,4 +1,16 @@
 #include <algorithm>
+#include <bit>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include <nes/Bus.h>
 #include <nes/PPU.h>
@@ -70,6 +82,81 @@ std::array<PPU::Pixel, 64> PPU::defaultPalette = {
     Pixel{.r = 0x11, .g = 0x11, .b = 0x11, .a = 0xFF},
 };
 
+namespace {
+// Cycles are counted from the start of the pre-render scanline.
+int position(int scanline, int cycle) {
+    return (scanline + 1) * PPU::ScanlineCycles + cycle;
+}
+
+// Looks up `count` color indices in the 64-color palette, `count` is a multiple of 16.
+// Indices out of the palette give transparent black.
+void expandPixels(const std::uint8_t* indices, const PPU::Pixel* palette, PPU::Pixel* pixels, int count) {
+#if defined(__AVX2__)
+    // 8 pixels at a time, gathered from the palette
+    for (int i = 0; i != count; i += 8) {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+        __m256i inPalette = _mm256_cmpgt_epi32(_mm256_set1_epi32(64), index);
+
+        __m256i rgba = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(palette), index, inPalette, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), rgba);
+    }
+#elif defined(__aarch64__)
+    // 16 pixels at a time, each channel looked up in a 64-byte table
+    std::array<std::array<std::uint8_t, 64>, 4> channels;
+    for (int color = 0; color != 64; color++) {
+        channels[0][color] = palette[color].r;
+        channels[1][color] = palette[color].g;
+        channels[2][color] = palette[color].b;
+        channels[3][color] = palette[color].a;
+    }
+
+    uint8x16x4_t tables[4];
+    for (int c = 0; c != 4; c++) {
+        for (int part = 0; part != 4; part++) {
+            tables[c].val[part] = vld1q_u8(channels[c].data() + part * 16);
+        }
+    }
+
+    for (int i = 0; i != count; i += 16) {
+        // out of range lookups give 0
+        uint8x16_t index = vld1q_u8(indices + i);
+
+        uint8x16x4_t rgba;
+        for (int c = 0; c != 4; c++) {
+            rgba.val[c] = vqtbl4q_u8(tables[c], index);
+        }
+        vst4q_u8(reinterpret_cast<std::uint8_t*>(pixels + i), rgba);
+    }
+#else
+    for (int i = 0; i != count; i++) {
+        pixels[i] = indices[i] < 64 ? palette[indices[i]] : PPU::Pixel{};
+    }
+#endif
+}
+} // namespace
+
+std::span<const std::uint8_t> PPU::Frame::getRawPixels() const {
+    if (!expanded) {
+        for (int y = 0; y != Height; y++) {
+            expandPixels(indices.data() + y * Width, defaultPalette.data(), pixels.data() + (Height - y - 1) * Width, Width);
+        }
+
+        expanded = true;
+    }
+
+    return std::span{reinterpret_cast<const std::uint8_t*>(pixels.data()), Width * Height * sizeof(Pixel)};
+}
+
+std::uint64_t PPU::Frame::hash() const {
+    std::uint64_t hash = 0xCBF2'9CE4'8422'2325;
+    for (std::uint8_t byte : getRawPixels()) {
+        hash ^= byte;
+        hash *= 0x0000'0100'0000'01B3;
+    }
+
+    return hash;
+}
+
 void PPU::connect(Bus* bus) {
     this->bus = bus;
     assert(this->bus != nullptr);
@@ -100,7 +187,390 @@ void PPU::clock() {
     incrementCycle();
 }
 
+void PPU::run(int cycles) {
+    while (cycles > 0) {
+        if (atIdleScanlineStart() && cycles >= ScanlineCycles) {
+            skipScanline();
+            cycles -= ScanlineCycles;
+        } else if (atVisibleScanlineStart() && cycles >= ScanlineRenderCycles) {
+            renderScanline();
+            cycles -= ScanlineRenderCycles;
+        } else if (int idle = std::min(idleCycles(), cycles); idle > 0) {
+            skipIdleCycles(idle);
+            cycles -= idle;
+        } else {
+            clock();
+            cycles--;
+        }
+    }
+}
+
+bool PPU::atVisibleScanlineStart() const {
+    return cycle == 0 && scanline >= 0 && scanline < 240;
+}
+
+void PPU::renderScanline() {
+    assert(atVisibleScanlineStart());
+
+    frameComplete = false;
+
+    const bool renderingEnabled = mask.renderingEnabled();
+    const bool showBackground = mask.showBackground();
+    const bool showSprites = mask.showSprites();
+
+    // Skipped and deferred scanlines are only composed here for sprite 0 hits.
+    const bool drawn = renderingEnabled && !frameSkipping;
+    const bool deferred = drawn && renderWorkers != nullptr;
+    const bool composed = renderingEnabled && ((drawn && !deferred) || sprite0HitPossible);
+
+    if (deferred) {
+        deferScanline();
+    }
+
+    ScanlinePixels pixels;
+
+    if (showSprites) {
+        if (composed) {
+            layoutSprites(pixels, secondaryOamData.data(), spritePatternShifterLo.data(), spritePatternShifterHi.data(), spriteCounterX.data(), spriteCount);
+        }
+
+        for (int i = 0; i != spriteCount; i++) {
+            // what updateShifters() leaves behind after cycles 2-256
+            int shifts = 255 - std::min<int>(spriteCounterX[i], 255);
+            spriteCounterX[i] = std::max(spriteCounterX[i] - 255, 0);
+            spritePatternShifterLo[i] = shifts < 8 ? spritePatternShifterLo[i] << shifts : 0;
+            spritePatternShifterHi[i] = shifts < 8 ? spritePatternShifterHi[i] << shifts : 0;
+        }
+    }
+
+    if (showBackground && composed) {
+        layoutShifters(pixels, bgPatternShifterLo, bgPatternShifterHi, bgAttributeShifterLo, bgAttributeShifterHi);
+    }
+
+    // Name table rows 30 and 31 are the attribute bytes, which the canvas does not have.
+    const bool backgroundDrawn = composed && showBackground;
+    const bool fromCanvas = backgroundDrawn && backgroundCanvas != nullptr && vramAddr.coarseY < 30;
+    const bool fetchAll = backgroundDrawn && !fromCanvas;
+
+    // the tile fetched at the end of the previous scanline
+    TileCache::Row bgRow = TileCache::decode(bgTileByteLo, bgTileByteHi);
+
+    if (fromCanvas) {
+        for (int column = 0; column != 8; column++) {
+            pixels.bg[8 + column] = (bgAtByte << 2) | bgRow[column];
+        }
+
+        // the tiles fetched below, but the last one which is not drawn
+        const int row = (vramAddr.nametableY * 30 + vramAddr.coarseY) * 8 + vramAddr.fineY;
+        const int column = vramAddr.nametableX * 32 + vramAddr.coarseX;
+        backgroundCanvas->read(*bus, control.backgroundPatternAddr(), row, column, 31, pixels.bg.data() + 16);
+    }
+
+    // Cycles 1-256 in steps of 8: the shifters are reloaded, then the next tile is fetched.
+    for (int tile = 0; tile != 32; tile++) {
+        if (showBackground) {
+            bgPatternShifterLo <<= 1;
+            bgPatternShifterHi <<= 1;
+
+            bgAttributeShifterLo <<= 1;
+            bgAttributeShifterHi <<= 1;
+        }
+
+        loadShifters();
+
+        if (fetchAll) {
+            for (int column = 0; column != 8; column++) {
+                pixels.bg[8 + tile * 8 + column] = (bgAtByte << 2) | bgRow[column];
+            }
+        }
+
+        // Only the last 3 fetches leave something behind:
+        // the shifters end up with the last 2 tiles loaded, and the latches with the last tile fetched.
+        if (fetchAll || tile >= 32 - 3) {
+            fetchTile();
+        }
+
+        if (fetchAll) {
+            bgRow = bus->ppuTileRow(control.backgroundPatternAddr() + (bgNtByte << 4) + vramAddr.fineY);
+        }
+
+        incrementHorizontal();
+
+        if (showBackground) {
+            bgPatternShifterLo <<= 7;
+            bgPatternShifterHi <<= 7;
+
+            bgAttributeShifterLo <<= 7;
+            bgAttributeShifterHi <<= 7;
+        }
+    }
+
+    cycle = ScanlineRenderCycles;
+
+    if (composed) {
+        std::span<std::uint8_t> row = (drawn && !deferred) ? frame.getRow(scanline) : std::span<std::uint8_t>{};
+
+        if (composeScanline(pixels, mask, fineX, sprite0HitPossible, colors, row)) {
+            status.setSprite0Hit();
+        }
+    }
+
+    // cycle 256
+    incrementVertical();
+}
+
+void PPU::layoutShifters(ScanlinePixels& pixels, std::uint16_t patternLo, std::uint16_t patternHi, std::uint16_t attributeLo, std::uint16_t attributeHi) {
+    for (int column = 0; column != 8; column++) {
+        // shifted once before the first pixel
+        const std::uint16_t bit = 0x4000 >> column;
+
+        std::uint8_t pixel = (((patternHi & bit) > 0) << 1) | ((patternLo & bit) > 0);
+        std::uint8_t palette = (((attributeHi & bit) > 0) << 1) | ((attributeLo & bit) > 0);
+        pixels.bg[column] = (palette << 2) | pixel;
+    }
+}
+
+void PPU::layoutSprites(ScanlinePixels& pixels,
+                        const std::uint8_t* secondaryOam,
+                        const std::uint8_t* patternLo,
+                        const std::uint8_t* patternHi,
+                        const std::uint8_t* counterX,
+                        int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        const std::uint8_t* sprite = secondaryOam + i * 4;
+        std::uint8_t spriteX = counterX[i];
+
+        for (int column = 0; column != 8 && spriteX + column < 256; column++) {
+            std::uint8_t fgPixelLo = ((patternLo[i] << column) & 0x80) > 0;
+            std::uint8_t fgPixelHi = ((patternHi[i] << column) & 0x80) > 0;
+            std::uint8_t fgPixel = (fgPixelHi << 1) | fgPixelLo;
+
+            if (fgPixel) {
+                pixels.fg[spriteX + column] = fgPixel;
+                pixels.fgAttributes[spriteX + column] = sprite[2];
+                pixels.fgSprite0[spriteX + column] = (i == 0);
+            }
+        }
+    }
+}
+
+bool PPU::composeScanline(const ScanlinePixels& pixels,
+                          MaskRegister mask,
+                          std::uint8_t fineX,
+                          bool sprite0HitPossible,
+                          const std::array<std::uint8_t, 32>& colors,
+                          std::span<std::uint8_t> row) {
+    bool sprite0Hit = false;
+
+    // same composition as renderFrame()
+    for (int x = 0; x != 256; x++) {
+        std::uint8_t bgPixel = 0x00;
+        std::uint8_t bgPalette = 0x00;
+
+        if (mask.showBackground() && (x >= 8 || mask.showBackgroundLeft())) {
+            bgPixel = pixels.bg[x + fineX] & 0b11;
+            bgPalette = pixels.bg[x + fineX] >> 2;
+        }
+
+        std::uint8_t fgPixel = 0x00;
+        if (mask.showSprites() && (x >= 8 || mask.showSpritesLeft())) {
+            fgPixel = pixels.fg[x];
+        }
+
+        std::uint8_t finalPalette = bgPixel ? bgPalette : 0x00;
+        std::uint8_t finalPixel = bgPixel;
+
+        if (fgPixel) {
+            bool fgBehindBg = (pixels.fgAttributes[x] >> 5) & 1;
+
+            if (!bgPixel || !fgBehindBg) {
+                finalPalette = (pixels.fgAttributes[x] & 0b11) | (1 << 2);
+                finalPixel = fgPixel;
+            }
+
+            if (bgPixel && sprite0HitPossible && pixels.fgSprite0[x]) {
+                if (mask.showBackgroundLeft() || mask.showSpritesLeft() || x >= 8) {
+                    sprite0Hit = true;
+                }
+            }
+        }
+
+        if (!row.empty()) {
+            row[x] = colors[(finalPalette << 2) | finalPixel];
+        }
+    }
+
+    return sprite0Hit;
+}
+
+void PPU::drawDeferredScanline(const DeferredScanline& deferred) {
+    const VideoMemory& memory = *deferred.memory;
+
+    ScanlinePixels pixels;
+
+    if (deferred.mask.showSprites()) {
+        layoutSprites(pixels,
+                      deferred.secondaryOamData.data(),
+                      deferred.spritePatternShifterLo.data(),
+                      deferred.spritePatternShifterHi.data(),
+                      deferred.spriteCounterX.data(),
+                      deferred.spriteCount);
+    }
+
+    if (deferred.mask.showBackground()) {
+        layoutShifters(pixels, deferred.bgPatternShifterLo, deferred.bgPatternShifterHi, deferred.bgAttributeShifterLo, deferred.bgAttributeShifterHi);
+
+        LoopyRegister vramAddr = deferred.vramAddr;
+        std::uint8_t bgAtByte = deferred.bgAtByte;
+        TileCache::Row bgRow = TileCache::decode(deferred.bgTileByteLo, deferred.bgTileByteHi);
+
+        for (int tile = 0; tile != 32; tile++) {
+            for (int column = 0; column != 8; column++) {
+                pixels.bg[8 + tile * 8 + column] = (bgAtByte << 2) | bgRow[column];
+            }
+
+            // same fetches as fetchTile(), from the copy of the memory
+            std::uint8_t bgNtByte = memory.nameTables[vramAddr.reg & 0x0FFF];
+            bgAtByte = memory.nameTables[0x03C0 | (vramAddr.reg & 0x0C00) | ((vramAddr.reg >> 4) & 0x38) | ((vramAddr.reg >> 2) & 0x07)];
+
+            if (vramAddr.coarseY & 0x02) {
+                bgAtByte >>= 4;
+            }
+            if (vramAddr.coarseX & 0x02) {
+                bgAtByte >>= 2;
+            }
+
+            bgAtByte &= 0x03;
+
+            std::uint16_t addr = deferred.control.backgroundPatternAddr() + (bgNtByte << 4) + vramAddr.fineY;
+            const std::uint8_t* lo = memory.chr->data() + memory.chrPages[addr >> 10] + (addr & 0x03FF);
+            bgRow = TileCache::decode(lo[0], lo[8]);
+
+            // same as incrementHorizontal(), rendering is enabled
+            if (vramAddr.coarseX == 31) {
+                vramAddr.coarseX = 0;
+                vramAddr.nametableX = ~vramAddr.nametableX;
+            } else {
+                vramAddr.coarseX++;
+            }
+        }
+    }
+
+    composeScanline(pixels, deferred.mask, deferred.fineX, false, deferred.colors, deferred.row);
+}
+
+void PPU::deferScanline() {
+    assert(atVisibleScanlineStart());
+    assert(bus != nullptr);
+
+    deferredScanlines.push_back(DeferredScanline{
+        .row = frame.getRow(scanline),
+        .memory = bus->ppuMemory(),
+        .control = control,
+        .mask = mask,
+        .vramAddr = vramAddr,
+        .fineX = fineX,
+        .bgAtByte = bgAtByte,
+        .bgTileByteLo = bgTileByteLo,
+        .bgTileByteHi = bgTileByteHi,
+        .bgPatternShifterLo = bgPatternShifterLo,
+        .bgPatternShifterHi = bgPatternShifterHi,
+        .bgAttributeShifterLo = bgAttributeShifterLo,
+        .bgAttributeShifterHi = bgAttributeShifterHi,
+        .secondaryOamData = secondaryOamData,
+        .spritePatternShifterLo = spritePatternShifterLo,
+        .spritePatternShifterHi = spritePatternShifterHi,
+        .spriteCounterX = spriteCounterX,
+        .spriteCount = spriteCount,
+        .colors = colors,
+    });
+
+    if (deferredScanlines.size() == DeferredScanlineGroup) {
+        submitDeferredScanlines();
+    }
+}
+
+void PPU::submitDeferredScanlines() {
+    if (deferredScanlines.empty()) {
+        return;
+    }
+
+    renderWorkers->push([scanlines = std::move(deferredScanlines)] {
+        for (const DeferredScanline& deferred : scanlines) {
+            drawDeferredScanline(deferred);
+        }
+    });
+
+    deferredScanlines.clear();
+}
+
+void PPU::finishDeferredScanlines() {
+    if (renderWorkers == nullptr) {
+        return;
+    }
+
+    submitDeferredScanlines();
+    renderWorkers->wait();
+}
+
+bool PPU::atIdleScanlineStart() const {
+    return cycle == 0 && scanline >= -1 && scanline < 240 && !mask.renderingEnabled();
+}
+
+void PPU::skipScanline() {
+    assert(atIdleScanlineStart());
+
+    frameComplete = false;
+
+    if (scanline == -1) {
+        status.resetSprite0Hit();
+        status.resetSpriteOverflow();
+        status.resetVblank();
+    }
+
+    // Without rendering, v does not move and the shifters do not shift,
+    // so every tile fetch of the scanline reads the same bytes and the last load keeps them.
+    fetchTile();
+    loadShifters();
+
+    if (scanline != -1) {
+        cycle = 257;
+        secondaryOamClearAndSpriteEvaluation();
+        cycle = 340;
+        calculateSpritesPatternAddr();
+    }
+
+    cycle = ScanlineCycles - 1;
+    incrementCycle();
+}
+
+int PPU::idleCycles() const {
+    const int current = position(scanline, cycle);
+
+    if (scanline == 240 || (scanline == 241 && cycle == 0)) {
+        return position(241, 1) - current;
+    }
+
+    if (current > position(241, 1)) {
+        return position(260, 340) - current;
+    }
+
+    return 0;
+}
+
+void PPU::skipIdleCycles(int cycles) {
+    assert(cycles >= 0 && cycles <= idleCycles());
+
+    frameComplete = false;
+
+    const int next = position(scanline, cycle) + cycles;
+    scanline = next / ScanlineCycles - 1;
+    cycle = next % ScanlineCycles;
+}
+
 void PPU::reset() {
+    finishDeferredScanlines();
+
     control.reg = 0;
     mask.reg = 0;
     status.reg = 0;
@@ -124,8 +594,15 @@ void PPU::reset() {
     bgAttributeShifterLo = 0;
     bgAttributeShifterHi = 0;
 
+    spritePatternShifterLo.fill(0);
+    spritePatternShifterHi.fill(0);
+    spriteCounterX.fill(0);
     spriteCount = 0;
     sprite0HitPossible = false;
+
+    updateColors();
+    scanlineSpritesOutdated = true;
+    invalidateBackground();
 }
 
 std::uint8_t PPU::readStatus() {
@@ -169,8 +646,13 @@ std::uint8_t PPU::readPalette(std::uint16_t addr) const {
 
 void PPU::writeCtrl(std::uint8_t data) {
     bool prev = control.generateNMI();
+    std::uint8_t prevSpriteHeight = control.spriteHeight();
 
     control.write(data);
+    if (control.spriteHeight() != prevSpriteHeight) {
+        scanlineSpritesOutdated = true;
+    }
+
     tramAddr.nametableX = data & 1;
     tramAddr.nametableY = (data >> 1) & 1;
 
@@ -179,12 +661,18 @@ void PPU::writeCtrl(std::uint8_t data) {
     // changing the NMI flag in bit 7 of $2000 from 0 to 1 will immediately generate an NMI.
     if (status.isInVblank() && !prev && control.generateNMI()) {
         assert(bus != nullptr);
-        bus->getCPU().nmi();
+        bus->nmi();
     }
 }
 
 void PPU::writeMask(std::uint8_t data) {
+    bool prev = mask.isGreyscale();
+
     mask.write(data);
+
+    if (mask.isGreyscale() != prev) {
+        updateColors();
+    }
 }
 
 void PPU::writeOamAddr(std::uint8_t data) {
@@ -192,6 +680,11 @@ void PPU::writeOamAddr(std::uint8_t data) {
 }
 
 void PPU::writeOamData(std::uint8_t data) {
+    // only the Y positions decide the scanlines of the sprites
+    if (oamAddr % 4 == 0) {
+        scanlineSpritesOutdated = true;
+    }
+
     // Writes will increment oamAddr after the writing
     primaryOamData[oamAddr++] = data;
 }
@@ -232,11 +725,20 @@ void PPU::writeOamDMA(std::span<std::uint8_t, 256> buffer) {
     for (std::uint8_t data : buffer) {
         primaryOamData[oamAddr++] = data;
     }
+
+    scanlineSpritesOutdated = true;
 }
 
 void PPU::writePalette(std::uint16_t addr, std::uint8_t data) {
     assert(addr >= 0x3F00 && addr < 0x3F20);
     paletteTable[addr - 0x3F00] = data;
+
+    // $3F00/$3F04/$3F08/$3F0C are also the colors of $3F10/$3F14/$3F18/$3F1C
+    std::uint8_t index = addr - 0x3F00;
+    updateColor(index);
+    if ((index & 0x03) == 0) {
+        updateColor(index | 0x10);
+    }
 }
 
 void PPU::serialize(std::ostream& os) const {
@@ -248,10 +750,16 @@ void PPU::serialize(std::ostream& os) const {
 void PPU::deserialize(std::istream& is) {
     auto begin = reinterpret_cast<char*>(this) + offsetof(PPU, control);
     auto end = reinterpret_cast<char*>(this) + offsetof(PPU, bus);
+    finishDeferredScanlines();
     is.read(begin, end - begin);
+
+    updateColors();
+    scanlineSpritesOutdated = true;
+    invalidateBackground();
 }
 
-const PPU::Frame& PPU::getFrame() const {
+const PPU::Frame& PPU::getFrame() {
+    finishDeferredScanlines();
     return frame;
 }
 
@@ -259,11 +767,61 @@ bool PPU::isFrameComplete() const {
     return frameComplete;
 }
 
-PPU::Pixel PPU::getColor(std::uint8_t palette, std::uint8_t pixel) {
-    std::uint8_t index = read(0x3F00 + ((palette << 2) | pixel));
-    assert(index >= 0 && index < 64);
+void PPU::setFrameSkipping(bool skipping) {
+    frameSkipping = skipping;
+}
+
+void PPU::setBackgroundCanvas(bool enabled) {
+    if (enabled == (backgroundCanvas != nullptr)) {
+        return;
+    }
+
+    backgroundCanvas = enabled ? std::make_unique<BackgroundCanvas>() : nullptr;
+}
+
+void PPU::invalidateBackground() {
+    if (backgroundCanvas != nullptr) {
+        backgroundCanvas->invalidateAll();
+    }
+}
+
+void PPU::setDeferredRendering(bool deferred) {
+    if (deferred == (renderWorkers != nullptr)) {
+        return;
+    }
+
+    if (deferred) {
+        // the emulation keeps a core for itself
+        renderWorkers = std::make_unique<WorkerPool>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    } else {
+        finishDeferredScanlines();
+        renderWorkers.reset();
+    }
+}
 
-    return defaultPalette[index];
+int PPU::cyclesUntilEvent(bool mapperScanlines) const {
+    const int current = position(scanline, cycle);
+
+    // The last cycle of the last vertical blanking scanline completes the frame.
+    int next = position(260, 340);
+
+    if (current <= position(241, 1)) {
+        next = position(241, 1);
+    }
+
+    // See processMapper()
+    if (mapperScanlines && mask.renderingEnabled()) {
+        int line = (cycle <= 260) ? scanline : scanline + 1;
+        if (line < 240) {
+            next = std::min(next, position(line, 260));
+        }
+    }
+
+    return next - current;
+}
+
+PPU::Pixel PPU::getColor(std::uint8_t palette, std::uint8_t pixel) {
+    return defaultPalette[colors[(palette << 2) | pixel]];
 }
 
 std::uint8_t PPU::read(std::uint16_t addr) {
@@ -273,9 +831,32 @@ std::uint8_t PPU::read(std::uint16_t addr) {
 
 void PPU::write(std::uint16_t addr, std::uint8_t data) {
     assert(bus != nullptr);
+
+    if (backgroundCanvas != nullptr) {
+        if (addr < 0x2000) {
+            // any tile may use the pattern
+            backgroundCanvas->invalidateAll();
+        } else if (addr < 0x3F00) {
+            backgroundCanvas->invalidate(0x2000 | (addr & 0x0FFF));
+        }
+    }
+
     return bus->ppuWrite(addr, data);
 }
 
+void PPU::updateColors() {
+    for (std::uint8_t index = 0; index != colors.size(); index++) {
+        updateColor(index);
+    }
+}
+
+void PPU::updateColor(std::uint8_t index) {
+    // same mirroring as the PPU bus
+    std::uint8_t addr = ((index & 0x13) == 0x10) ? (index & 0x0F) : index;
+    colors[index] = readPalette(0x3F00 + addr);
+    assert(colors[index] >= 0 && colors[index] < 64);
+}
+
 void PPU::incrementAddr() {
     vramAddr.reg += control.addrIncrement();
 }
@@ -327,6 +908,24 @@ void PPU::transferVerticalBits() {
     }
 }
 
+void PPU::fetchTile() {
+    // same fetches as visibleFrameAndPreRender()
+    bgNtByte = read(0x2000 | (vramAddr.reg & 0x0FFF));
+    bgAtByte = read(0x23C0 | (vramAddr.reg & 0x0C00) | ((vramAddr.reg >> 4) & 0x38) | ((vramAddr.reg >> 2) & 0x07));
+
+    if (vramAddr.coarseY & 0x02) {
+        bgAtByte >>= 4;
+    }
+    if (vramAddr.coarseX & 0x02) {
+        bgAtByte >>= 2;
+    }
+
+    bgAtByte &= 0x03;
+
+    bgTileByteLo = read(control.backgroundPatternAddr() + (bgNtByte << 4) + vramAddr.fineY + 0);
+    bgTileByteHi = read(control.backgroundPatternAddr() + (bgNtByte << 4) + vramAddr.fineY + 8);
+}
+
 void PPU::loadShifters() {
     bgPatternShifterLo = (bgPatternShifterLo & 0xFF00) | bgTileByteLo;
     bgPatternShifterHi = (bgPatternShifterHi & 0xFF00) | bgTileByteHi;
@@ -348,17 +947,87 @@ void PPU::updateShifters() {
     }
 
     if (mask.showSprites() && cycle >= 2 && cycle < 257) {
-        for (int i = 0; i != spriteCount; i++) {
-            std::uint8_t* sprite = secondaryOamData.data() + i * 4;
+        updateSpriteShifters();
+    }
+}
 
-            if (sprite[3] > 0) {
-                sprite[3]--;
-            } else {
-                spritePatternShifterLo[i] <<= 1;
-                spritePatternShifterHi[i] <<= 1;
-            }
+// The sprites are kept as one byte per sprite in each array, so all of them fit in a 16-byte vector.
+// Sprites after spriteCount are cleared during the evaluation, they stay transparent and at X 0.
+void PPU::updateSpriteShifters() {
+#if defined(__SSE2__) || defined(_M_X64)
+    static_assert(MaximumSpriteCount == 16);
+
+    __m128i counter = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spriteCounterX.data()));
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spritePatternShifterLo.data()));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spritePatternShifterHi.data()));
+
+    // a byte added to itself is shifted left by 1
+    __m128i drawn = _mm_cmpeq_epi8(counter, _mm_setzero_si128());
+    lo = _mm_add_epi8(lo, _mm_and_si128(lo, drawn));
+    hi = _mm_add_epi8(hi, _mm_and_si128(hi, drawn));
+    counter = _mm_subs_epu8(counter, _mm_set1_epi8(1));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(spriteCounterX.data()), counter);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(spritePatternShifterLo.data()), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(spritePatternShifterHi.data()), hi);
+#elif defined(__aarch64__)
+    static_assert(MaximumSpriteCount == 16);
+
+    uint8x16_t counter = vld1q_u8(spriteCounterX.data());
+    uint8x16_t lo = vld1q_u8(spritePatternShifterLo.data());
+    uint8x16_t hi = vld1q_u8(spritePatternShifterHi.data());
+
+    uint8x16_t drawn = vceqzq_u8(counter);
+    lo = vaddq_u8(lo, vandq_u8(lo, drawn));
+    hi = vaddq_u8(hi, vandq_u8(hi, drawn));
+    counter = vqsubq_u8(counter, vdupq_n_u8(1));
+
+    vst1q_u8(spriteCounterX.data(), counter);
+    vst1q_u8(spritePatternShifterLo.data(), lo);
+    vst1q_u8(spritePatternShifterHi.data(), hi);
+#else
+    for (int i = 0; i != spriteCount; i++) {
+        if (spriteCounterX[i] > 0) {
+            spriteCounterX[i]--;
+        } else {
+            spritePatternShifterLo[i] <<= 1;
+            spritePatternShifterHi[i] <<= 1;
         }
     }
+#endif
+}
+
+int PPU::firstOpaqueSprite() const {
+#if defined(__SSE2__) || defined(_M_X64)
+    __m128i counter = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spriteCounterX.data()));
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spritePatternShifterLo.data()));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spritePatternShifterHi.data()));
+
+    // the top bits of the shifters are the pixels, one of them is set for an opaque pixel
+    __m128i drawn = _mm_cmpeq_epi8(counter, _mm_setzero_si128());
+    unsigned opaque = _mm_movemask_epi8(_mm_and_si128(drawn, _mm_or_si128(lo, hi)));
+
+    return opaque ? std::countr_zero(opaque) : -1;
+#elif defined(__aarch64__)
+    uint8x16_t counter = vld1q_u8(spriteCounterX.data());
+    uint8x16_t lo = vld1q_u8(spritePatternShifterLo.data());
+    uint8x16_t hi = vld1q_u8(spritePatternShifterHi.data());
+
+    uint8x16_t opaque = vandq_u8(vceqzq_u8(counter), vtstq_u8(vorrq_u8(lo, hi), vdupq_n_u8(0x80)));
+
+    // 4 bits per sprite
+    std::uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(opaque), 4)), 0);
+
+    return bits ? std::countr_zero(bits) / 4 : -1;
+#else
+    for (int i = 0; i != spriteCount; i++) {
+        if (spriteCounterX[i] == 0 && ((spritePatternShifterLo[i] | spritePatternShifterHi[i]) & 0x80)) {
+            return i;
+        }
+    }
+
+    return -1;
+#endif
 }
 
 void PPU::visibleFrameAndPreRender() {
@@ -386,7 +1055,7 @@ void PPU::visibleFrameAndPreRender() {
         switch ((cycle - 1) % 8) {
         case 0:
             loadShifters();
-            bgNtByte = read(0x2000 | vramAddr.reg & 0x0FFF);
+            bgNtByte = read(0x2000 | (vramAddr.reg & 0x0FFF));
             break;
         case 2:
             bgAtByte = read(0x23C0 | (vramAddr.reg & 0x0C00) | ((vramAddr.reg >> 4) & 0x38) | ((vramAddr.reg >> 2) & 0x07));
@@ -441,7 +1110,7 @@ void PPU::verticalBlanking() {
 
         if (control.generateNMI()) {
             assert(bus != nullptr);
-            bus->getCPU().nmi();
+            bus->nmi();
         }
     }
 }
@@ -454,6 +1123,11 @@ void PPU::renderFrame() {
         return;
     }
 
+    // Only sprite 0 hits are observable when the frame is skipped.
+    if (frameSkipping && !sprite0HitPossible) {
+        return;
+    }
+
     std::uint8_t bgPixel = 0x00;
     std::uint8_t bgPalette = 0x00;
 
@@ -475,26 +1149,17 @@ void PPU::renderFrame() {
     bool sprite0BeingRendered = false;
 
     if (mask.showSprites() && (finalX >= 8 || mask.showSpritesLeft())) {
-        for (int i = 0; i != spriteCount; i++) {
+        if (int i = firstOpaqueSprite(); i != -1) {
             std::uint8_t* sprite = secondaryOamData.data() + i * 4;
-            std::uint8_t spriteX = sprite[3];
-
-            if (spriteX == 0) {
-                std::uint8_t fgPixelLo = (spritePatternShifterLo[i] & 0x80) > 0;
-                std::uint8_t fgPixelHi = (spritePatternShifterHi[i] & 0x80) > 0;
-                fgPixel = (fgPixelHi << 1) | fgPixelLo;
 
-                fgPalette = (sprite[2] & 0b11) | (1 << 2);
-                fgBehindBg = (sprite[2] >> 5) & 1;
+            std::uint8_t fgPixelLo = (spritePatternShifterLo[i] & 0x80) > 0;
+            std::uint8_t fgPixelHi = (spritePatternShifterHi[i] & 0x80) > 0;
+            fgPixel = (fgPixelHi << 1) | fgPixelLo;
 
-                if (fgPixel) {
-                    if (i == 0) {
-                        sprite0BeingRendered = true;
-                    }
+            fgPalette = (sprite[2] & 0b11) | (1 << 2);
+            fgBehindBg = (sprite[2] >> 5) & 1;
 
-                    break;
-                }
-            }
+            sprite0BeingRendered = (i == 0);
         }
     }
 
@@ -531,7 +1196,9 @@ void PPU::renderFrame() {
         }
     }
 
-    frame.setPixel(finalX, finalY, getColor(finalPalette, finalPixel));
+    if (!frameSkipping) {
+        frame.setPixel(finalX, finalY, colors[(finalPalette << 2) | finalPixel]);
+    }
 }
 
 void PPU::incrementCycle() {
@@ -541,6 +1208,9 @@ void PPU::incrementCycle() {
         if (++scanline == 261) {
             scanline = -1;
             frameComplete = true;
+
+            // the next frame draws over the same rows
+            finishDeferredScanlines();
         }
     }
 }
@@ -552,36 +1222,51 @@ void PPU::secondaryOamClearAndSpriteEvaluation() {
         std::fill(secondaryOamData.begin(), secondaryOamData.end(), 0);
         std::fill(spritePatternShifterLo.begin(), spritePatternShifterLo.end(), 0);
         std::fill(spritePatternShifterHi.begin(), spritePatternShifterHi.end(), 0);
+        std::fill(spriteCounterX.begin(), spriteCounterX.end(), 0);
 
         spriteCount = 0;
         sprite0HitPossible = false;
 
-        for (int i = 0; i != 64 && spriteCount <= MaximumSpriteCount; i++) {
-            std::uint8_t* sprite = primaryOamData.data() + i * 4;
+        if (scanlineSpritesOutdated) {
+            updateScanlineSprites();
+        }
 
-            std::uint8_t spriteY = sprite[0];
-            std::size_t diff = static_cast<std::size_t>(scanline) - static_cast<std::size_t>(spriteY);
+        const std::uint8_t count = scanlineSpriteCount[scanline];
 
-            if (diff >= 0 && diff < control.spriteHeight()) {
-                if (spriteCount < MaximumSpriteCount) {
-                    if (i == 0) {
-                        sprite0HitPossible = true;
-                    }
-
-                    std::copy(sprite, sprite + 4, std::next(secondaryOamData.begin(), 4 * spriteCount));
-                }
+        for (; spriteCount != count && spriteCount != MaximumSpriteCount; spriteCount++) {
+            std::uint8_t i = scanlineSprites[scanline][spriteCount];
+            std::uint8_t* sprite = primaryOamData.data() + i * 4;
 
-                spriteCount++;
+            if (i == 0) {
+                sprite0HitPossible = true;
             }
+
+            std::copy(sprite, sprite + 4, std::next(secondaryOamData.begin(), 4 * spriteCount));
+            spriteCounterX[spriteCount] = sprite[3];
         }
 
-        if (spriteCount > MaximumSpriteCount) {
-            spriteCount = MaximumSpriteCount;
+        if (count > MaximumSpriteCount) {
             status.setSpriteOverflow();
         }
     }
 }
 
+void PPU::updateScanlineSprites() {
+    scanlineSpriteCount.fill(0);
+
+    for (int i = 0; i != 64; i++) {
+        int spriteY = primaryOamData[i * 4];
+
+        for (int line = spriteY; line != spriteY + control.spriteHeight() && line < 240; line++) {
+            if (scanlineSpriteCount[line] <= MaximumSpriteCount) {
+                scanlineSprites[line][scanlineSpriteCount[line]++] = i;
+            }
+        }
+    }
+
+    scanlineSpritesOutdated = false;
+}
+
 void PPU::calculateSpritesPatternAddr() {
     assert(scanline >= 0 && scanline < 240);
 
@@ -647,6 +1332,6 @@ void PPU::calculateSpritesPatternAddr() {
 void PPU::processMapper() {
     if (cycle == 260 && scanline < 240 && mask.renderingEnabled()) {
         assert(bus != nullptr);
-        bus->getMapper().scanline();
+        bus->mapperScanline();
     }
 }
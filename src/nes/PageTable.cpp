@@ -0,0 +1,21 @@
+#include <cassert>
+
+#include <nes/PageTable.h>
+
+void PageTable::mapRead(std::uint16_t addr, std::size_t size, const std::uint8_t* memory) {
+    assert(addr % PageSize == 0 && size % PageSize == 0);
+    assert(addr + size <= PageSize * PageCount);
+
+    for (std::size_t offset = 0; offset != size; offset += PageSize) {
+        read[(addr + offset) / PageSize] = memory ? memory + offset : nullptr;
+    }
+}
+
+void PageTable::mapWrite(std::uint16_t addr, std::size_t size, std::uint8_t* memory) {
+    assert(addr % PageSize == 0 && size % PageSize == 0);
+    assert(addr + size <= PageSize * PageCount);
+
+    for (std::size_t offset = 0; offset != size; offset += PageSize) {
+        write[(addr + offset) / PageSize] = memory ? memory + offset : nullptr;
+    }
+}
@@ -0,0 +1,17 @@
+#include <nes/TileCache.h>
+
+void TileCache::reset(std::span<const std::uint8_t> chr) {
+    // 16 bytes per tile, 8 rows per tile
+    rows.assign(chr.size() / 2, Row{});
+    valid.assign(chr.size() / 2, false);
+}
+
+TileCache::Row TileCache::decode(std::uint8_t lo, std::uint8_t hi) {
+    Row row;
+
+    for (int column = 0; column != 8; column++) {
+        row[column] = (((hi >> (7 - column)) & 1) << 1) | ((lo >> (7 - column)) & 1);
+    }
+
+    return row;
+}
@@ -0,0 +1,63 @@
+#include <cassert>
+
+#include <nes/WorkerPool.h>
+
+WorkerPool::WorkerPool(unsigned threads) {
+    assert(threads > 0);
+
+    for (unsigned i = 0; i != threads; i++) {
+        this->threads.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    wait();
+
+    // an empty queue stops a thread
+    queued.release(threads.size());
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::push(Task task) {
+    unfinished++;
+
+    {
+        std::lock_guard lock{mtx};
+        que.emplace(std::move(task));
+    }
+
+    queued.release();
+}
+
+void WorkerPool::wait() {
+    for (std::size_t count = unfinished; count != 0; count = unfinished) {
+        unfinished.wait(count);
+    }
+}
+
+void WorkerPool::work() {
+    while (true) {
+        queued.acquire();
+
+        Task task;
+
+        {
+            std::lock_guard lock{mtx};
+            if (que.empty()) {
+                return;
+            }
+
+            task = std::move(que.front());
+            que.pop();
+        }
+
+        task();
+
+        if (--unfinished == 0) {
+            unfinished.notify_all();
+        }
+    }
+}
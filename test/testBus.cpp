@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <nes/Bus.h>
+#include <nes/NesFile.h>
+
+namespace {
+constexpr int Frames = 120;
+
+// nestest, and mmc3_stress.nes, generated by scripts/gen_stress_rom.py. The stress ROM renders random name tables
+// and sprites with NMIs, MMC3 scanline IRQs and APU frame IRQs enabled. At random points in the frame it writes
+// the scroll (splits after sprite 0 hits and in the IRQ handler), toggles rendering, switches MMC3 CHR and PRG banks
+// and the mirroring, writes the palette, OAM and PPUCTRL, and does an OAM DMA in every NMI.
+constexpr std::string_view NesFiles[] = {"nestest.nes", "mmc3_stress.nes"};
+
+void powerUp(Bus& bus, std::string_view nesFile, Bus::PpuSyncMode mode) {
+    auto cartridge = loadNesFile(nesFile);
+    ASSERT_TRUE(cartridge.has_value());
+
+    bus.insert(std::move(cartridge.value()));
+    bus.powerUp();
+    bus.setPpuSyncMode(mode);
+}
+
+std::vector<std::uint64_t> frameHashes(std::string_view nesFile, Bus::PpuSyncMode mode) {
+    Bus bus;
+    powerUp(bus, nesFile, mode);
+
+    std::vector<std::uint64_t> hashes;
+    for (int i = 0; i != Frames; i++) {
+        bus.runFrame();
+        hashes.push_back(bus.getPPU().getFrame().hash());
+    }
+
+    return hashes;
+}
+} // namespace
+
+GTEST_TEST(Bus, TwoInstances) {
+    for (std::string_view nesFile : NesFiles) {
+        Bus first;
+        Bus second;
+        powerUp(first, nesFile, Bus::PpuSyncMode::CatchUp);
+        powerUp(second, nesFile, Bus::PpuSyncMode::CatchUp);
+
+        // The two consoles run interleaved, and must not share any state.
+        for (int i = 0; i != Frames; i++) {
+            first.runFrame();
+            second.runFrame();
+
+            ASSERT_EQ(first.getPPU().getFrame().hash(), second.getPPU().getFrame().hash()) << nesFile << ", frame " << i;
+        }
+    }
+}
+
+GTEST_TEST(Bus, CatchUpMatchesLockstep) {
+    for (std::string_view nesFile : NesFiles) {
+        ASSERT_EQ(frameHashes(nesFile, Bus::PpuSyncMode::Lockstep), frameHashes(nesFile, Bus::PpuSyncMode::CatchUp)) << nesFile;
+    }
+}
+
+GTEST_TEST(Bus, ThreadedMatchesLockstep) {
+    for (std::string_view nesFile : NesFiles) {
+        ASSERT_EQ(frameHashes(nesFile, Bus::PpuSyncMode::Lockstep), frameHashes(nesFile, Bus::PpuSyncMode::Threaded)) << nesFile;
+    }
+}